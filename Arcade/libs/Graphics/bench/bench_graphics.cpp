@@ -0,0 +1,365 @@
+/**
+ * @file bench_graphics.cpp
+ * @brief Google Benchmark suite for the Graphics primitives and blending.
+ *
+ * Every benchmark renders into a headless Screen (or a bare ScreenBuffer), so
+ * it runs without a display. Reported counters:
+ * - pixels/s: estimated pixels written per second (DrawCommand::cost());
+ * - allocs/call: heap allocations per iteration (a draw call, a frame for
+ *   BM_Frame), counted by the global operator new of this executable.
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <random>
+#include <thread>
+#include "BitmapFont.h"
+#include "Color.h"
+#include "DrawList.h"
+#include "FrameRecorder.h"
+#include "pixel_scale.h"
+#include "Screen.h"
+#include "ScreenBuffer.h"
+#include "Sprite.h"
+
+// Allocation counter ======================================================= //
+
+static std::atomic<uint64_t> g_allocations{0};
+
+// Every replaceable form goes through malloc/free. GCC still pairs the
+// inlined std::free with the operator new it sees at the call site and
+// reports -Wmismatched-new-delete, which is wrong for replaced operators.
+#if defined(__GNUC__) and !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+
+#if defined(__GNUC__) and !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+// Helpers ================================================================== //
+
+constexpr uint32_t WIDTH = 640;
+constexpr uint32_t HEIGHT = 480;
+
+inline Color shape_color(bool translucent) { return translucent ? Color(0x80FF8000) : Color::Orange(); }
+inline Color outline_color(bool translucent) { return translucent ? Color(0x80FFFFFF) : Color::White(); }
+
+// Report the pixel rate and the allocations per iteration of a benchmark
+struct Counters {
+    benchmark::State& state;
+    uint64_t pixels_per_call;
+    uint64_t allocations_start;
+
+    Counters(benchmark::State& s, uint64_t pixels)
+        : state(s), pixels_per_call(pixels), allocations_start(g_allocations.load()) {}
+
+    ~Counters() {
+        double calls = static_cast<double>(state.iterations());
+        state.counters["pixels/s"] = benchmark::Counter(calls * pixels_per_call, benchmark::Counter::kIsRate);
+        state.counters["allocs/call"] = (g_allocations.load() - allocations_start) / std::max(calls, 1.0);
+    }
+};
+
+// Primitives =============================================================== //
+// Args: size (pixels), translucent (0 or 1)
+
+// Args: size, translucent, antialiased
+void BM_Line(benchmark::State& state) {
+    Screen screen;
+    screen.init_headless(WIDTH, HEIGHT);
+    screen.set_antialiasing(state.range(2));
+    float length = static_cast<float>(state.range(0));
+    Line2D line(Vec2D(10, 10), Vec2D(10 + length, 10 + length / 3));
+    Color color = shape_color(state.range(1));
+
+    Counters counters(state, DrawCommand::line(line.get_p0(), line.get_p1(), color).cost());
+    for (auto _ : state) screen.draw(line, color);
+}
+
+// Args: size, translucent, threads
+void BM_Triangle(benchmark::State& state) {
+    Screen screen;
+    screen.init_headless(WIDTH, HEIGHT);
+    screen.set_raster_threads(static_cast<unsigned>(state.range(2)));
+    float size = static_cast<float>(state.range(0));
+    Triangle2D triangle(Vec2D(5, 5), Vec2D(5 + size, 5 + size / 4), Vec2D(5 + size / 3, 5 + size));
+    Color color = shape_color(state.range(1));
+
+    Counters counters(state, DrawCommand::triangle(triangle.get_p0(), triangle.get_p1(), triangle.get_p2(),
+                                                   color, true, color).cost());
+    for (auto _ : state) screen.draw(triangle, color, true, color);
+}
+
+void BM_Rectangle(benchmark::State& state) {
+    Screen screen;
+    screen.init_headless(WIDTH, HEIGHT);
+    float size = static_cast<float>(state.range(0));
+    Rectangle2D rectangle(Vec2D(5, 5), Vec2D(5 + size, 5 + size * 3 / 4));
+    Color color = shape_color(state.range(1));
+
+    Counters counters(state, DrawCommand::rectangle(rectangle.get_top_left_point(), rectangle.get_bottom_right_point(),
+                                                    outline_color(state.range(1)), true, color).cost());
+    for (auto _ : state) screen.draw(rectangle, outline_color(state.range(1)), true, color);
+}
+
+// Args: size, translucent, antialiased
+void BM_Circle(benchmark::State& state) {
+    Screen screen;
+    screen.init_headless(WIDTH, HEIGHT);
+    screen.set_antialiasing(state.range(2));
+    float radius = static_cast<float>(state.range(0)) / 2;
+    Circle2D circle(Vec2D(WIDTH / 2, HEIGHT / 2), radius);
+    Color color = shape_color(state.range(1));
+
+    Counters counters(state, DrawCommand::circle(circle.get_center_point(), radius,
+                                                 outline_color(state.range(1)), true, color).cost());
+    for (auto _ : state) screen.draw(circle, outline_color(state.range(1)), true, color);
+}
+
+// A size x size ball: opaque inside, a translucent rim (ALPHA only), and
+// transparent (magenta key, alpha 0) corners.
+// Args: size, blit mode (0: OPAQUE, 1: COLOR_KEY, 2: ALPHA)
+void BM_Sprite(benchmark::State& state) {
+    Screen screen;
+    screen.init_headless(WIDTH, HEIGHT);
+    int size = static_cast<int>(state.range(0));
+    auto mode = static_cast<Sprite::BlitMode>(state.range(1));
+
+    SDL_Surface* ball = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_ARGB8888);
+    float radius = size / 2.0f;
+    for (int y = 0; y < size; y++) {
+        uint32_t* row = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(ball->pixels) + y * ball->pitch);
+        for (int x = 0; x < size; x++) {
+            float distance = std::hypot(x + 0.5f - radius, y + 0.5f - radius);
+            row[x] = distance > radius ? (Color::MAGENTA & 0x00FFFFFF) :
+                     distance > radius - 2 ? 0x80FF8000 : Color::ORANGE;
+        }
+    }
+    SpriteAtlas atlas;
+    int id = atlas.add(ball, mode);
+    atlas.pack();
+    SDL_FreeSurface(ball);
+
+    Counters counters(state, DrawCommand::sprite(atlas[id], 5, 5).cost());
+    for (auto _ : state) screen.draw(atlas[id], 5, 5);
+}
+
+// A score readout, laid out once and then drawn from the font cache.
+// Args: proportional (0 or 1), translucent
+void BM_Text(benchmark::State& state) {
+    Screen screen;
+    screen.init_headless(WIDTH, HEIGHT);
+    BitmapFont font(state.range(0) ? BitmapFont::Spacing::PROPORTIONAL : BitmapFont::Spacing::FIXED);
+    const std::string text = "SCORE 0012340  LIVES 3";
+    Color color = shape_color(state.range(1));
+
+    Counters counters(state, font.layout(text)->pixels);
+    for (auto _ : state) screen.draw(font, text, 8, 8, color);
+}
+
+BENCHMARK(BM_Line)->ArgsProduct({{16, 128, 512}, {0, 1}, {0, 1}});
+BENCHMARK(BM_Triangle)->ArgsProduct({{16, 128, 448}, {0, 1}, {1, 4, 8}})->UseRealTime();
+BENCHMARK(BM_Rectangle)->ArgsProduct({{16, 128, 448}, {0, 1}});
+BENCHMARK(BM_Circle)->ArgsProduct({{16, 128, 448}, {0, 1}, {0, 1}});
+BENCHMARK(BM_Sprite)->ArgsProduct({{16, 64, 256}, {0, 1, 2}});
+BENCHMARK(BM_Text)->ArgsProduct({{0, 1}, {0, 1}});
+
+// Blending ================================================================= //
+
+void BM_AlphaBlending(benchmark::State& state) {
+    std::mt19937 rng(1);
+    std::vector<uint32_t> pixels(4096);
+    for (uint32_t& pixel : pixels) pixel = rng();
+    Color source = shape_color(state.range(0));
+
+    Counters counters(state, pixels.size());
+    for (auto _ : state) {
+        for (uint32_t& pixel : pixels) pixel = Color::alpha_blending(source, Color(pixel)).get_pixel_color();
+        benchmark::DoNotOptimize(pixels.data());
+    }
+}
+
+// Args: translucent, inside a frame (0 or 1)
+void BM_SetPixel(benchmark::State& state) {
+    ScreenBuffer buffer;
+    buffer.init(WIDTH, HEIGHT);
+    if (state.range(1)) buffer.begin_frame();
+    Color color = shape_color(state.range(0));
+
+    Counters counters(state, 256);
+    for (auto _ : state) {
+        for (int i = 0; i < 256; i++) buffer.set_pixel(color, i, i);
+    }
+    buffer.end_frame();
+}
+
+// Args: width, translucent
+void BM_BlendSpan(benchmark::State& state) {
+    ScreenBuffer buffer;
+    buffer.init(WIDTH, HEIGHT);
+    buffer.begin_frame();
+    int width = static_cast<int>(state.range(0));
+    Color color = shape_color(state.range(1));
+
+    Counters counters(state, width);
+    for (auto _ : state) buffer.blend_span(0, width - 1, 10, color);
+    buffer.end_frame();
+}
+
+// A translucent filled circle and its outline drawn in every blend mode.
+// Args: size, blend mode (0: OPAQUE, 1: SOURCE_OVER, 2: ADDITIVE, 3: MULTIPLY, 4: XOR)
+void BM_BlendMode(benchmark::State& state) {
+    Screen screen;
+    screen.init_headless(WIDTH, HEIGHT);
+    screen.set_blend_mode(static_cast<BlendMode>(state.range(1)));
+    float radius = static_cast<float>(state.range(0)) / 2;
+    Circle2D circle(Vec2D(WIDTH / 2, HEIGHT / 2), radius);
+    Color color = shape_color(true);
+
+    Counters counters(state, DrawCommand::circle(circle.get_center_point(), radius,
+                                                 outline_color(true), true, color).cost());
+    for (auto _ : state) screen.draw(circle, outline_color(true), true, color);
+}
+
+BENCHMARK(BM_AlphaBlending)->Arg(0)->Arg(1);
+BENCHMARK(BM_SetPixel)->ArgsProduct({{0, 1}, {0, 1}});
+BENCHMARK(BM_BlendSpan)->ArgsProduct({{8, 64, 640}, {0, 1}});
+BENCHMARK(BM_BlendMode)->ArgsProduct({{16, 448}, benchmark::CreateDenseRange(0, BLEND_MODES - 1, 1)});
+
+// Present ================================================================== //
+
+// Magnify a 224x288 frame into a window buffer.
+// Args: factor
+void BM_ScaleNearest(benchmark::State& state) {
+    const int width = 224, height = 288;
+    int factor = static_cast<int>(state.range(0));
+    std::vector<uint32_t> src(width * height, 0xFF204060);
+    std::vector<uint32_t> dst(width * height * factor * factor);
+
+    Counters counters(state, dst.size());
+    for (auto _ : state) {
+        scale_nearest(src.data(), width * 4, dst.data(), width * factor * 4, 0, 0, width, height, factor);
+        benchmark::DoNotOptimize(dst.data());
+    }
+}
+
+BENCHMARK(BM_ScaleNearest)->DenseRange(1, 4);
+
+// Game thread side of the frame capture: the copy of a frame into the ring,
+// the writer being given the time to catch up between frames (untimed).
+// Args: format (0: Y4M, 1: RAW)
+void BM_Capture(benchmark::State& state) {
+    ScreenBuffer frame;
+    frame.init(WIDTH, HEIGHT);
+    frame.clear_surface(Color::Orange());
+    FrameRecorder recorder;
+    std::string path = (std::filesystem::temp_directory_path() / "bench_capture").string();
+    if (!recorder.start(path, WIDTH, HEIGHT, static_cast<FrameRecorder::Format>(state.range(0)))) {
+        state.SkipWithError("Cannot open the capture");
+        return;
+    }
+
+    {
+        Counters counters(state, static_cast<uint64_t>(WIDTH) * HEIGHT);
+        for (auto _ : state) {
+            state.PauseTiming();
+            while (recorder.stats().written < recorder.stats().captured) std::this_thread::yield();
+            state.ResumeTiming();
+            recorder.push(frame);
+        }
+    }
+    recorder.stop();
+    state.counters["dropped"] = recorder.stats().dropped / std::max(static_cast<double>(state.iterations()), 1.0);
+    std::filesystem::remove(path);
+    std::filesystem::remove(path + ".idx");
+}
+
+BENCHMARK(BM_Capture)->Arg(0)->Arg(1);
+
+// Frames =================================================================== //
+
+// A whole frame of mixed primitives, presented.
+// Args: buffer width, buffer height, render mode, threads
+void BM_Frame(benchmark::State& state) {
+    uint32_t width = static_cast<uint32_t>(state.range(0));
+    uint32_t height = static_cast<uint32_t>(state.range(1));
+
+    Screen screen;
+    screen.init_headless(width, height);
+    screen.set_render_mode(static_cast<Screen::RenderMode>(state.range(2)));
+    screen.set_raster_threads(static_cast<unsigned>(state.range(3)));
+
+    // The same scene every frame: 200 primitives of every kind
+    std::mt19937 rng(42);
+    std::vector<DrawCommand> scene;
+    uint64_t pixels = 0;
+    for (int i = 0; i < 200; i++) {
+        Vec2D p0(rng() % width, rng() % height), p1(rng() % width, rng() % height), p2(rng() % width, rng() % height);
+        Color color(static_cast<uint32_t>(rng()) | 0x40000000);
+        switch (i % 4) {
+            case 0: scene.push_back(DrawCommand::line(p0, p1, color)); break;
+            case 1: scene.push_back(DrawCommand::triangle(p0, p1, p2, color, true, color)); break;
+            case 2: scene.push_back(DrawCommand::rectangle(p0, p1, color, true, color)); break;
+            case 3: scene.push_back(DrawCommand::circle(p0, rng() % 40, color, true, color)); break;
+        }
+        pixels += scene.back().cost();
+    }
+
+    Counters counters(state, pixels);
+    for (auto _ : state) {
+        for (const DrawCommand& command : scene) {
+            const float* v = command.v;
+            Color color(command.color);
+            switch (command.type) {
+                case DrawCommand::LINE:
+                    screen.draw(Line2D(Vec2D(v[0], v[1]), Vec2D(v[2], v[3])), color);
+                    break;
+                case DrawCommand::TRIANGLE:
+                    screen.draw(Triangle2D(Vec2D(v[0], v[1]), Vec2D(v[2], v[3]), Vec2D(v[4], v[5])), color, true, color);
+                    break;
+                case DrawCommand::RECTANGLE:
+                    screen.draw(Rectangle2D(Vec2D(v[0], v[1]), Vec2D(v[2], v[3])), color, true, color);
+                    break;
+                default:
+                    screen.draw(Circle2D(Vec2D(v[0], v[1]), v[2]), color, true, color);
+                    break;
+            }
+        }
+        screen.swap_screens();
+    }
+}
+
+BENCHMARK(BM_Frame)
+    ->ArgsProduct({{224}, {288}, {0, 2}, {1, 4, 8}})
+    ->ArgsProduct({{640}, {480}, {0, 2}, {1, 4, 8}})
+    ->ArgsProduct({{1280}, {720}, {0, 2}, {1, 4, 8}})
+    ->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,101 @@
+/**
+ * @file BitmapFont.h
+ * @brief Bitmap fonts drawn as pre-rendered, cached text spans.
+ *
+ * The glyphs are one-bit masks kept side by side in a glyph atlas built once,
+ * from the built-in 5x7 ASCII font or from a BMP sheet of equal cells. Glyphs
+ * are advanced by the cell width (FIXED) or by their own ink width
+ * (PROPORTIONAL), plus the letter spacing.
+ *
+ * A string is laid out once into a TextRun: the glyph rows are merged into
+ * one list of horizontal spans per text row, ready to be filled with the
+ * text color. The runs are cached by string, so a HUD redrawn every frame
+ * costs a hash lookup and one span fill per run of ink. The Screen draws a
+ * whole string with a single command.
+ *
+ * The cache is not thread-safe; it is dropped when MAX_CACHED_TEXTS strings
+ * are reached (runs still in use stay alive through their shared_ptr).
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#ifndef GRAPHICS_BITMAP_FONT_H
+#define GRAPHICS_BITMAP_FONT_H
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A laid out string: spans of ink relative to its top-left corner
+struct TextRun {
+    struct Span {
+        int32_t x;
+        int32_t length;
+    };
+
+    int width;
+    int height;
+    std::vector<Span> spans;
+    std::vector<uint32_t> row_start;  // row r holds spans[start[r], start[r + 1])
+    uint64_t pixels;                  // ink pixels
+
+    inline const Span* spans_begin(int row) const {return spans.data() + row_start[row];}
+    inline const Span* spans_end(int row) const {return spans.data() + row_start[row + 1];}
+};
+
+class BitmapFont {
+public:
+    enum class Spacing {FIXED, PROPORTIONAL};
+
+    // Class variables ====================================================== //
+    static constexpr char FIRST_CHAR = ' ';
+    static constexpr char LAST_CHAR = '~';
+    static constexpr size_t MAX_CACHED_TEXTS = 256;
+
+    // Constructors ========================================================= //
+    explicit BitmapFont(Spacing spacing=Spacing::FIXED);  // the built-in 5x7 font
+
+    // Instance methods ===================================================== //
+    // Sheet of cell_width x cell_height glyphs from FIRST_CHAR, row by row;
+    // ink is any pixel brighter than black. False (font unchanged) on failure.
+    bool load_bmp(const std::string& path, int cell_width, int cell_height);
+
+    // Negative spacings overlap the glyphs (or lines), the pen never moves back
+    inline void set_letter_spacing(int pixels) {m_letter_spacing = pixels; m_cache.clear();}
+    inline void set_line_spacing(int pixels) {m_line_spacing = pixels; m_cache.clear();}
+    inline int cell_width() const {return m_cell_width;}
+    inline int cell_height() const {return m_cell_height;}
+    int advance(char c) const;
+
+    // Laid out and cached; '\n' starts a new line, unknown characters are '?'
+    std::shared_ptr<const TextRun> layout(const std::string& text);
+    inline size_t cached_texts() const {return m_cache.size();}
+
+private:
+    struct Glyph {
+        int atlas_x;  // first column of the cell in the atlas
+        int ink_x0;   // first column drawn
+        int width;    // columns drawn
+    };
+
+    // Instance variables =================================================== //
+    Spacing m_spacing;
+    int m_cell_width;
+    int m_cell_height;
+    int m_letter_spacing;
+    int m_line_spacing;
+    std::vector<uint8_t> m_atlas;  // 1: ink, glyph after glyph on every row
+    int m_atlas_width;
+    std::vector<Glyph> m_glyphs;   // FIRST_CHAR to LAST_CHAR
+    std::unordered_map<std::string, std::shared_ptr<const TextRun>> m_cache;
+
+    // Instance methods ===================================================== //
+    void build_glyphs();
+    const Glyph& glyph(char c) const;
+    std::shared_ptr<const TextRun> render(const std::string& text) const;
+};
+
+#endif // GRAPHICS_BITMAP_FONT_H
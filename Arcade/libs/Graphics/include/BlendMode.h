@@ -0,0 +1,97 @@
+/**
+ * @file BlendMode.h
+ * @brief Compile-time blend modes for the pixel and span writers.
+ *
+ * The mode is a template parameter: every writer is instantiated once per
+ * mode, so its inner loop holds the blend equation alone and no per-pixel
+ * branch. Source colors are ARGB, the alpha weighting the effect; every mode
+ * writes opaque pixels.
+ *
+ * OPAQUE       s (alpha ignored)
+ * SOURCE_OVER  a * s + (1 - a) * d, exactly like Color::alpha_blending
+ * ADDITIVE     min(d + a * s, 1)
+ * MULTIPLY     a * s * d + (1 - a) * d
+ * XOR          d ^ s on the RGB bits (alpha ignored)
+ *
+ * SOURCE_OVER spans go through the SIMD span_blend kernels, the other modes
+ * are plain loops left to the compiler.
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#ifndef GRAPHICS_BLEND_MODE_H
+#define GRAPHICS_BLEND_MODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include "Color.h"
+#include "span_blend.h"
+
+enum class BlendMode : uint8_t {OPAQUE, SOURCE_OVER, ADDITIVE, MULTIPLY, XOR};
+
+constexpr int BLEND_MODES = 5;
+
+namespace blend_detail {
+
+constexpr uint32_t OPAQUE_ALPHA = 0xFFu << Color::ALPHA_SHIFT;
+constexpr uint32_t RGB_MASK = 0x00FFFFFF;
+
+// Apply op(source channel, destination channel, alpha) to the three channels
+template <typename Op>
+constexpr uint32_t per_channel(uint32_t src, uint32_t dst, Op op) {
+    const uint32_t alpha = src >> Color::ALPHA_SHIFT;
+    auto channel = [&](int shift) {return op((src >> shift) & 0xFF, (dst >> shift) & 0xFF, alpha) << shift;};
+    return OPAQUE_ALPHA | channel(Color::RED_SHIFT) | channel(Color::GREEN_SHIFT) | channel(Color::BLUE_SHIFT);
+}
+
+}  // namespace blend_detail
+
+// The source ARGB color blended over the destination pixel
+template <BlendMode M>
+constexpr uint32_t blend_argb(uint32_t src, uint32_t dst) {
+    using namespace blend_detail;
+
+    if constexpr (M == BlendMode::OPAQUE) {
+        return src | OPAQUE_ALPHA;
+    } else if constexpr (M == BlendMode::SOURCE_OVER) {
+        return Color::alpha_blending(Color(src), Color(dst)).get_pixel_color();
+    } else if constexpr (M == BlendMode::ADDITIVE) {
+        return per_channel(src, dst, [](uint32_t s, uint32_t d, uint32_t a) {
+            return std::min<uint32_t>(d + Color::div_255(s * a), 255);
+        });
+    } else if constexpr (M == BlendMode::MULTIPLY) {
+        return per_channel(src, dst, [](uint32_t s, uint32_t d, uint32_t a) {
+            return Color::div_255(Color::div_255(s * d) * a + d * (255 - a));
+        });
+    } else {
+        return ((dst ^ src) & RGB_MASK) | OPAQUE_ALPHA;
+    }
+}
+
+// Blend one constant ARGB color over count destination pixels
+template <BlendMode M>
+inline void blend_solid(uint32_t* dst, size_t count, uint32_t argb) {
+    if constexpr (M == BlendMode::OPAQUE) {
+        std::fill_n(dst, count, argb | blend_detail::OPAQUE_ALPHA);
+    } else if constexpr (M == BlendMode::SOURCE_OVER) {
+        span_blend_solid(dst, count, argb);
+    } else {
+        for (size_t i = 0; i < count; i++) dst[i] = blend_argb<M>(argb, dst[i]);
+    }
+}
+
+// Blend count per-pixel ARGB source colors over count destination pixels
+template <BlendMode M>
+inline void blend_pixels(uint32_t* dst, const uint32_t* src, size_t count) {
+    if constexpr (M == BlendMode::OPAQUE) {
+        for (size_t i = 0; i < count; i++) dst[i] = src[i] | blend_detail::OPAQUE_ALPHA;
+    } else if constexpr (M == BlendMode::SOURCE_OVER) {
+        span_blend_pixels(dst, src, count);
+    } else {
+        for (size_t i = 0; i < count; i++) dst[i] = blend_argb<M>(src[i], dst[i]);
+    }
+}
+
+#endif // GRAPHICS_BLEND_MODE_H
@@ -1,6 +1,13 @@
 /**
  * @file Color.h
- * @brief 
+ * @brief Packed ARGB8888 color value type.
+ *
+ * The color is stored as a single 32 bit integer in ARGB8888 layout (the same
+ * layout used by the ScreenBuffer surface), so every channel access is a shift
+ * and a mask and the whole class can be used in constant expressions.
+ * Conversion to any other pixel format happens only at the ScreenBuffer/window
+ * boundary.
+ *
  * @author SimoX
  * @date 2024-10-24
  */
@@ -9,58 +16,105 @@
 #define GRAPHICS_COLOR_H
 
 #include <stdint.h>
-#include <SDL2/SDL.h>
-
-struct SDL_PixelFormat;
 
 class Color {
 public:
     // Class variables ====================================================== //
-    static const SDL_PixelFormat* m_format;
-    static const uint32_t BLACK, GRAY, WHITE, RED, GREEN, BLUE, CYAN, MAGENTA, YELLOW, ORANGE, PURPLE;
+    static constexpr uint32_t BLACK = 0xFF000000;    // ARGB format
+    static constexpr uint32_t GRAY = 0xFF808080;     // ARGB format
+    static constexpr uint32_t WHITE = 0xFFFFFFFF;    // ARGB format
+    static constexpr uint32_t RED = 0xFFFF0000;      // ARGB format
+    static constexpr uint32_t GREEN = 0xFF00FF00;    // ARGB format
+    static constexpr uint32_t BLUE = 0xFF0000FF;     // ARGB format
+    static constexpr uint32_t CYAN = 0xFF00FFFF;     // ARGB format
+    static constexpr uint32_t MAGENTA = 0xFFFF00FF;  // ARGB format
+    static constexpr uint32_t YELLOW = 0xFFFFFF00;   // ARGB format
+    static constexpr uint32_t ORANGE = 0xFFFFA500;   // ARGB format
+    static constexpr uint32_t PURPLE = 0xFF800080;   // ARGB format
+
+    static constexpr int ALPHA_SHIFT = 24;
+    static constexpr int RED_SHIFT = 16;
+    static constexpr int GREEN_SHIFT = 8;
+    static constexpr int BLUE_SHIFT = 0;
 
     // Class methods ======================================================== //
-    static void init_color_format(const SDL_PixelFormat* format);
-    static Color alpha_blending(const Color& source, const Color& destination); // alpha blending
-    
+    static constexpr Color alpha_blending(const Color& source, const Color& destination); // alpha blending
+
+    /**
+     * Exact integer division by 255 for any x in [0, 255 * 255]
+     */
+    static constexpr uint32_t div_255(uint32_t x) {return (x + 1 + (x >> 8)) >> 8;}
+
     // Colors factory
-    static Color Black();
-    static Color Gray();
-    static Color White();
-    static Color Red();
-    static Color Green();
-    static Color Blue();
-    static Color Cyan();
-    static Color Magenta();
-    static Color Yellow();
-    static Color Orange();
-    static Color Purple();
+    static constexpr Color Black() { return Color(BLACK); }      // RGBA (  0,   0,   0, 255)
+    static constexpr Color Gray() { return Color(GRAY); }        // RGBA (128, 128, 128, 255)
+    static constexpr Color White() { return Color(WHITE); }      // RGBA (255, 255, 255, 255)
+    static constexpr Color Red() { return Color(RED); }          // RGBA (255,   0,   0, 255)
+    static constexpr Color Green() { return Color(GREEN); }      // RGBA (  0, 255,   0, 255)
+    static constexpr Color Blue() { return Color(BLUE); }        // RGBA (  0,   0, 255, 255)
+    static constexpr Color Cyan() { return Color(CYAN); }        // RGBA (  0, 255, 255, 255)
+    static constexpr Color Magenta() { return Color(MAGENTA); }  // RGBA (255,   0, 255, 255)
+    static constexpr Color Yellow() { return Color(YELLOW); }    // RGBA (255, 255,   0, 255)
+    static constexpr Color Orange() { return Color(ORANGE); }    // RGBA (255, 165,   0, 255)
+    static constexpr Color Purple() { return Color(PURPLE); }    // RGBA (128,   0, 128, 255)
 
     // Constructors ========================================================= //
-    Color() : Color(0xFF0000) {};
-    Color(uint32_t color);
-    Color(uint8_t r, uint8_t g, uint8_t b, uint8_t a);
+    constexpr Color() : Color(0xFF0000) {};
+    constexpr Color(uint32_t argb_color) : m_color(argb_color) {}
+    constexpr Color(uint8_t r, uint8_t g, uint8_t b, uint8_t a) : m_color(pack(r, g, b, a)) {}
 
     // Instance methods ===================================================== //
-    inline uint32_t get_pixel_color() const {return m_color;}
-    void set_RGBA(uint8_t r, uint8_t g, uint8_t b, uint8_t a);
-    void set_red(uint8_t r);
-    void set_green(uint8_t g);
-    void set_blue(uint8_t b);
-    void set_alpha(uint8_t a);
-
-    uint8_t get_red() const;
-    uint8_t get_green() const;
-    uint8_t get_blue() const;
-    uint8_t get_alpha() const;
+    constexpr uint32_t get_pixel_color() const {return m_color;}
+    constexpr void set_RGBA(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {m_color = pack(r, g, b, a);}
+    constexpr void set_red(uint8_t r) {set_channel(r, RED_SHIFT);}
+    constexpr void set_green(uint8_t g) {set_channel(g, GREEN_SHIFT);}
+    constexpr void set_blue(uint8_t b) {set_channel(b, BLUE_SHIFT);}
+    constexpr void set_alpha(uint8_t a) {set_channel(a, ALPHA_SHIFT);}
+
+    constexpr uint8_t get_red() const {return get_channel(RED_SHIFT);}
+    constexpr uint8_t get_green() const {return get_channel(GREEN_SHIFT);}
+    constexpr uint8_t get_blue() const {return get_channel(BLUE_SHIFT);}
+    constexpr uint8_t get_alpha() const {return get_channel(ALPHA_SHIFT);}
 
     // Operator overloading ================================================= //
-    inline bool operator==(const Color& other) const {return m_color == other.m_color;}
-    inline bool operator!=(const Color& other) const {return  !(*this == other);}
+    constexpr bool operator==(const Color& other) const {return m_color == other.m_color;}
+    constexpr bool operator!=(const Color& other) const {return  !(*this == other);}
 
 private:
+    // Instance variables =================================================== //
     uint32_t m_color;
 
+    // Class methods ======================================================== //
+    static constexpr uint32_t pack(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+        return (uint32_t(a) << ALPHA_SHIFT) | (uint32_t(r) << RED_SHIFT) |
+               (uint32_t(g) << GREEN_SHIFT) | (uint32_t(b) << BLUE_SHIFT);
+    }
+
+    // Instance methods ===================================================== //
+    constexpr uint8_t get_channel(int shift) const {return static_cast<uint8_t>(m_color >> shift);}
+    constexpr void set_channel(uint8_t value, int shift) {
+        m_color = (m_color & ~(0xFFu << shift)) | (uint32_t(value) << shift);
+    }
 };
 
-#endif // GRAPHICS_COLOR_H
\ No newline at end of file
+/**
+ * Blending equation: sourceRGB * sourceAlpha + destinationRGB * (1 - sourceAlpha)
+ *
+ * Evaluated in integer fixed point as (a * s + (255 - a) * d) / 255 for every
+ * channel; the result is always opaque.
+ */
+constexpr Color Color::alpha_blending(const Color& source, const Color& destination) {
+    const uint32_t alpha = source.get_alpha();
+    const uint32_t inv_alpha = 255 - alpha;
+
+    const uint32_t s = source.m_color;
+    const uint32_t d = destination.m_color;
+
+    const uint32_t r = div_255(((s >> RED_SHIFT) & 0xFF) * alpha + ((d >> RED_SHIFT) & 0xFF) * inv_alpha);
+    const uint32_t g = div_255(((s >> GREEN_SHIFT) & 0xFF) * alpha + ((d >> GREEN_SHIFT) & 0xFF) * inv_alpha);
+    const uint32_t b = div_255(((s >> BLUE_SHIFT) & 0xFF) * alpha + ((d >> BLUE_SHIFT) & 0xFF) * inv_alpha);
+
+    return Color((0xFFu << ALPHA_SHIFT) | (r << RED_SHIFT) | (g << GREEN_SHIFT) | (b << BLUE_SHIFT));
+}
+
+#endif // GRAPHICS_COLOR_H
@@ -0,0 +1,49 @@
+/**
+ * @file DirtyRegion.h
+ * @brief Set of damaged rectangles of the screen.
+ *
+ * Every draw call adds the bounding box of what it touched. Rectangles that
+ * overlap or touch are merged as they are added, and when there are too many
+ * of them they collapse into their bounding box, so the list always stays
+ * short and cheap to present.
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#ifndef GRAPHICS_DIRTY_REGION_H
+#define GRAPHICS_DIRTY_REGION_H
+
+#include <SDL2/SDL.h>
+#include <stddef.h>
+#include <vector>
+
+class DirtyRegion {
+public:
+    // Class variables ====================================================== //
+    static constexpr size_t MAX_RECTS = 32;
+
+    // Constructors ========================================================= //
+    DirtyRegion();
+
+    // Instance methods ===================================================== //
+    void set_bounds(int width, int height);
+    void add(int x0, int y0, int x1, int y1);  // corners included, clipped to the bounds
+    void add(const DirtyRegion& other);
+    inline void clear() {m_rects.clear();}
+
+    inline const std::vector<SDL_Rect>& rects() const {return m_rects;}
+    inline bool empty() const {return m_rects.empty();}
+    size_t area() const;
+
+private:
+    // Instance variables =================================================== //
+    std::vector<SDL_Rect> m_rects;  // never overlapping nor touching
+    int m_width;
+    int m_height;
+
+    // Instance methods ===================================================== //
+    void merge(SDL_Rect rect);
+};
+
+#endif // GRAPHICS_DIRTY_REGION_H
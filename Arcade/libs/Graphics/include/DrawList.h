@@ -0,0 +1,140 @@
+/**
+ * @file DrawList.h
+ * @brief Per-frame list of recorded draw commands.
+ *
+ * In deferred mode the Screen does not rasterize in its draw() methods: each
+ * call is recorded as a small POD DrawCommand in a vector that is reused every
+ * frame (no allocation once it has grown to the frame size), and the whole
+ * list is replayed at swap_screens().
+ *
+ * Every command carries the clip rectangle it was recorded with (the factory
+ * functions leave it unbounded).
+ *
+ * Before the replay, prepare() sums the estimated cost (pixels written) of
+ * the on-screen commands in submission order and, when a budget is set, drops
+ * the commands past the budget. The kept commands are then binned on a grid
+ * of BIN_SIZE x BIN_SIZE screen tiles: a command is culled when every tile it
+ * touches is fully covered by a later kept opaque rectangle.
+ *
+ * For the tiled renderer, build_bins() then groups the replayed commands by
+ * the bins they touch (submission order is kept inside every bin) and skips
+ * them in the bins covered by a later replayed opaque rectangle. Bins never
+ * share pixels, so they can be rasterized in parallel.
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#ifndef GRAPHICS_DRAW_LIST_H
+#define GRAPHICS_DRAW_LIST_H
+
+#include <SDL2/SDL.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+#include "BlendMode.h"
+#include "Color.h"
+#include "Vec2D.h"
+
+class Sprite;
+struct TextRun;
+
+struct DrawCommand {
+    enum Type : uint8_t {POINT, LINE, TRIANGLE, RECTANGLE, CIRCLE, SPRITE, TEXT};
+
+    Type type;
+    bool fill;
+    bool antialiased;     // outlines drawn with Wu's algorithm
+    BlendMode blend;      // SOURCE_OVER unless set by the Screen
+    uint32_t color;       // outline, ARGB
+    uint32_t fill_color;  // ARGB
+    float v[6];           // point: x, y / line: p0, p1 / triangle: p0, p1, p2 /
+                          // rectangle: top-left, bottom-right / circle: center, radius /
+                          // sprite, text: top-left
+    union {
+        const Sprite* sprite_ptr;  // owned by its SpriteAtlas
+        const TextRun* text_ptr;   // kept alive by the Screen until the replay
+    };
+    int x0, y0, x1, y1;   // bounding box in pixels, corners included (not clipped)
+    int16_t clip_x0, clip_y0, clip_x1, clip_y1;  // clip rectangle, corners included
+
+    static constexpr int16_t NO_CLIP_MIN = INT16_MIN;
+    static constexpr int16_t NO_CLIP_MAX = INT16_MAX;
+
+    // Factory functions ==================================================== //
+    static DrawCommand point(int x, int y, const Color& color);
+    static DrawCommand line(const Vec2D& p0, const Vec2D& p1, const Color& color);
+    static DrawCommand triangle(const Vec2D& p0, const Vec2D& p1, const Vec2D& p2,
+                                const Color& color, bool fill, const Color& fill_color);
+    static DrawCommand rectangle(const Vec2D& top_left, const Vec2D& bottom_right,
+                                 const Color& color, bool fill, const Color& fill_color);
+    static DrawCommand circle(const Vec2D& center, float radius,
+                              const Color& color, bool fill, const Color& fill_color);
+    static DrawCommand sprite(const Sprite& sprite, int x, int y);
+    static DrawCommand text(const TextRun& run, int x, int y, const Color& color);
+
+    // Instance methods ===================================================== //
+    void set_clip(const SDL_Rect& rect);
+    void set_antialiased();  // also grows the bounding box by the soft edge
+    uint64_t cost() const;  // estimated number of pixels written
+    bool is_opaque_cover() const;  // every pixel of the bounding box is overwritten
+};
+
+static_assert(std::is_trivially_copyable<DrawCommand>::value, "DrawCommand must stay POD");
+
+class DrawList {
+public:
+    // Class variables ====================================================== //
+    static constexpr int BIN_SIZE = 32;
+
+    struct Stats {
+        size_t recorded;  // commands submitted
+        size_t culled;    // off-screen or hidden by a later kept opaque rectangle
+        size_t dropped;   // over the cost budget
+        uint64_t cost;    // estimated pixels of the replayed commands
+    };
+
+    // Constructors ========================================================= //
+    DrawList();
+
+    // Instance methods ===================================================== //
+    void set_bounds(int width, int height);
+    inline void set_cost_budget(uint64_t pixels) {m_cost_budget = pixels;}  // 0: unlimited
+
+    inline void add(const DrawCommand& command) {m_commands.push_back(command);}
+    const std::vector<uint32_t>& prepare();  // indices to replay, in submission order
+    void build_bins();  // groups the indices of prepare() by bin
+    inline void clear() {m_commands.clear();}
+
+    inline const DrawCommand& operator[](size_t index) const {return m_commands[index];}
+    inline size_t size() const {return m_commands.size();}
+    inline bool empty() const {return m_commands.empty();}
+    inline const Stats& stats() const {return m_stats;}  // of the last prepare()
+
+    inline size_t bin_count() const {return m_cover.size();}
+    SDL_Rect bin_rect(size_t bin) const;
+    inline const uint32_t* bin_begin(size_t bin) const {return m_bin_indices.data() + m_bin_offsets[bin];}
+    inline const uint32_t* bin_end(size_t bin) const {return m_bin_indices.data() + m_bin_offsets[bin + 1];}
+
+private:
+    // Instance variables =================================================== //
+    std::vector<DrawCommand> m_commands;  // the per-frame arena
+    std::vector<uint32_t> m_replay;
+    std::vector<uint32_t> m_cover;  // per bin: 1 + index of the last kept opaque rectangle covering it
+    std::vector<uint32_t> m_bin_offsets;  // bin b holds m_bin_indices[offsets[b], offsets[b + 1])
+    std::vector<uint32_t> m_bin_indices;
+    int m_width;
+    int m_height;
+    int m_bins_x;
+    int m_bins_y;
+    uint64_t m_cost_budget;
+    Stats m_stats;
+
+    // Instance methods ===================================================== //
+    bool clip(const DrawCommand& command, int& x0, int& y0, int& x1, int& y1) const;
+    void mark_cover(const DrawCommand& command, uint32_t index);
+    bool is_covered(const DrawCommand& command, uint32_t index) const;
+};
+
+#endif // GRAPHICS_DRAW_LIST_H
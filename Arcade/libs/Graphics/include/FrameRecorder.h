@@ -0,0 +1,112 @@
+/**
+ * @file FrameRecorder.h
+ * @brief Streams presented frames to disk on a background writer thread.
+ *
+ * push() copies the frame into the next free slot of a ring of preallocated
+ * frames (one memcpy of the pixel rows, plus the palette of an indexed frame)
+ * and wakes the writer thread, which converts and writes the slots in order.
+ * When the disk falls behind and the ring is full the frame is dropped: the
+ * game thread never waits on the writer.
+ *
+ * Output formats:
+ * - Y4M: a YUV4MPEG2 stream in 4:4:4 (BT.601, limited range), readable by
+ *   ffmpeg and most players;
+ * - RAW: the ARGB8888 pixels of every frame back to back, rows without
+ *   padding, in the byte order of the machine.
+ *
+ * Both write an index next to the stream (path + ".idx"): a text line per
+ * written frame with its sequence number (dropped frames leave a gap), the
+ * byte offset of its pixels in the stream and the push time in microseconds
+ * since start().
+ *
+ * One game thread pushes, the writer thread is owned by the recorder.
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#ifndef GRAPHICS_FRAME_RECORDER_H
+#define GRAPHICS_FRAME_RECORDER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Palette.h"
+#include "ScreenBuffer.h"
+
+class FrameRecorder {
+public:
+    enum class Format {Y4M, RAW};
+
+    struct Stats {
+        uint64_t captured;  // copied into the ring
+        uint64_t dropped;   // the ring was full
+        uint64_t written;   // on disk
+    };
+
+    // Class variables ====================================================== //
+    static constexpr size_t DEFAULT_RING_FRAMES = 8;
+
+    // Constructors ========================================================= //
+    FrameRecorder();
+
+    // Instance methods ===================================================== //
+    // Open the stream and its index and start the writer. False on failure.
+    bool start(const std::string& path, int width, int height, Format format=Format::Y4M,
+               unsigned fps=60, size_t ring_frames=DEFAULT_RING_FRAMES);
+    void stop();  // writes the frames left in the ring, then closes the files
+    inline bool is_recording() const {return m_writer.joinable();}
+
+    // False when dropped. The frame must have the size given to start().
+    bool push(const ScreenBuffer& frame);
+    Stats stats() const;
+
+    // Destructor =========================================================== //
+    ~FrameRecorder();
+
+private:
+    struct Slot {
+        std::vector<uint8_t> pixels;  // rows without padding, 4 bytes (ARGB) or 1 (index) per pixel
+        uint32_t palette[Palette::MAX_COLORS];  // indexed frames only
+        bool indexed;
+        uint64_t sequence;
+        int64_t time_us;
+    };
+
+    // Instance variables =================================================== //
+    int m_width;
+    int m_height;
+    Format m_format;
+    std::ofstream m_stream;
+    std::ofstream m_index;
+    uint64_t m_stream_offset;  // writer thread only
+    std::chrono::steady_clock::time_point m_start;
+
+    std::vector<Slot> m_ring;
+    std::vector<uint32_t> m_argb;  // writer scratch: expanded indexed frame
+    std::vector<uint8_t> m_planes;  // writer scratch: Y, U and V planes
+    uint64_t m_sequence;  // frames pushed, dropped included (game thread only)
+    std::atomic<uint64_t> m_captured;  // slots filled, written by push()
+    std::atomic<uint64_t> m_consumed;  // slots freed, written by the writer
+    std::atomic<uint64_t> m_written;   // frames on disk
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint32_t> m_signals;  // the writer sleeps on it
+    std::atomic<bool> m_running;
+    bool m_failed;  // a write failed: the writer only frees the slots (writer thread only)
+    std::thread m_writer;
+
+    // Instance methods ===================================================== //
+    void write_loop();
+    void write_slot(const Slot& slot);
+    void to_yuv(const uint32_t* argb);
+
+    // Copy is NOT allowed
+    FrameRecorder(const FrameRecorder& other)=delete;
+    FrameRecorder& operator=(const FrameRecorder& other)=delete;
+};
+
+#endif // GRAPHICS_FRAME_RECORDER_H
@@ -0,0 +1,67 @@
+/**
+ * @file FrameStats.h
+ * @brief Per-frame render counters collected by the Screen.
+ *
+ * The counters are only collected when the library is built with
+ * GRAPHICS_ENABLE_STATS (CMake option of the same name): without it every
+ * GRAPHICS_STATS() statement compiles to nothing and the counters stay zero.
+ * The struct itself is always there, so the Screen layout does not depend on
+ * the option.
+ *
+ * Pixel counts are the DrawCommand::cost() estimates of the draw calls, taken
+ * before culling (see Screen::draw_stats() for what the draw list culled).
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#ifndef GRAPHICS_FRAME_STATS_H
+#define GRAPHICS_FRAME_STATS_H
+
+#include <chrono>
+#include <stdint.h>
+
+#ifdef GRAPHICS_ENABLE_STATS
+#define GRAPHICS_STATS(statement) statement
+#else
+#define GRAPHICS_STATS(statement)
+#endif
+
+struct FrameStats {
+    static constexpr int PRIMITIVE_TYPES = 7;  // one counter per DrawCommand::Type
+
+    uint64_t draw_calls[PRIMITIVE_TYPES];
+    uint64_t pixels_opaque;   // estimated pixels of the draw calls with opaque colors
+    uint64_t pixels_blended;  // estimated pixels of the other draw calls
+    uint64_t allocations;     // from the counter of set_allocation_counter(), if any
+    double raster_ms;         // draw calls (immediate) and draw list replay (deferred, tiled)
+    double blit_ms;           // copying and magnifying the frame to the window
+    double update_ms;         // SDL_UpdateWindowSurface(Rects) or SDL_RenderPresent
+    double frame_ms;          // from the previous swap_screens() to the end of this one
+
+    inline uint64_t total_draw_calls() const {
+        uint64_t total = 0;
+        for (uint64_t calls : draw_calls) total += calls;
+        return total;
+    }
+    inline uint64_t total_pixels() const {return pixels_opaque + pixels_blended;}
+};
+
+// Adds the lifetime of the timer to a millisecond counter
+class StatsTimer {
+public:
+    // Constructors ========================================================= //
+    explicit StatsTimer(double& total_ms) : m_total_ms(total_ms), m_start(std::chrono::steady_clock::now()) {}
+
+    // Destructor =========================================================== //
+    ~StatsTimer() {
+        m_total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+private:
+    // Instance variables =================================================== //
+    double& m_total_ms;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#endif // GRAPHICS_FRAME_STATS_H
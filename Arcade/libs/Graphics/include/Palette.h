@@ -0,0 +1,73 @@
+/**
+ * @file Palette.h
+ * @brief Up to 256 colors for the 8-bit indexed ScreenBuffer mode.
+ *
+ * An indexed buffer stores one palette index per pixel. Colors are mapped to
+ * the nearest palette entry (exact entries through a hash table, any other
+ * color through a 16x16x16 RGB cube of nearest indices), and translucent
+ * colors blend through a lookup table built with the palette:
+ * blend[source][alpha level][destination] is the nearest entry of the
+ * blended color, for ALPHA_LEVELS - 1 levels of alpha (0 leaves the pixel,
+ * ALPHA_LEVELS writes the source).
+ *
+ * The table holds size^2 * (ALPHA_LEVELS - 1) bytes and takes size^3 distance
+ * checks to build: meant for the handful of colors of retro games. A palette
+ * is immutable, so it can be shared by the raster threads.
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#ifndef GRAPHICS_PALETTE_H
+#define GRAPHICS_PALETTE_H
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "Color.h"
+
+class Palette {
+public:
+    // Class variables ====================================================== //
+    static constexpr int MAX_COLORS = 256;
+    static constexpr uint32_t ALPHA_LEVELS = 16;
+
+    // Constructors ========================================================= //
+    Palette();  // the Color constants, BLACK to PURPLE
+    explicit Palette(const std::vector<Color>& colors);  // opaque, at most MAX_COLORS
+
+    // Instance methods ===================================================== //
+    inline int size() const {return m_size;}
+    inline const uint32_t* colors() const {return m_colors.data();}  // MAX_COLORS ARGB entries (unused: black)
+    inline uint32_t color(uint8_t index) const {return m_colors[index];}
+
+    uint8_t index_of(uint32_t argb) const;  // nearest entry, alpha ignored
+
+    // Alpha (0 to 255) quantized to [0, ALPHA_LEVELS]
+    static inline uint32_t alpha_level(uint32_t alpha) {return (alpha * ALPHA_LEVELS + 127) / 255;}
+    // Destination index -> blended index, for a source entry and a level in [1, ALPHA_LEVELS)
+    inline const uint8_t* blend_table(uint8_t source, uint32_t level) const {
+        return m_blend.data() + (static_cast<size_t>(source) * (ALPHA_LEVELS - 1) + (level - 1)) * MAX_COLORS;
+    }
+    // Blend the ARGB color over the destination index
+    inline uint8_t blend(uint32_t argb, uint8_t destination) const {
+        uint32_t level = alpha_level(argb >> Color::ALPHA_SHIFT);
+        if (level == 0) return destination;
+        uint8_t source = index_of(argb);
+        return level == ALPHA_LEVELS ? source : blend_table(source, level)[destination];
+    }
+
+private:
+    // Instance variables =================================================== //
+    std::vector<uint32_t> m_colors;
+    int m_size;
+    std::unordered_map<uint32_t, uint8_t> m_exact;  // RGB -> index
+    std::vector<uint8_t> m_cube;   // 4 bit per channel RGB -> nearest index
+    std::vector<uint8_t> m_blend;  // [source][level - 1][destination]
+
+    // Instance methods ===================================================== //
+    void build();
+    uint8_t nearest(uint32_t argb) const;  // linear search
+};
+
+#endif // GRAPHICS_PALETTE_H
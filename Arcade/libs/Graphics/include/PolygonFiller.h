@@ -0,0 +1,51 @@
+/**
+ * @file PolygonFiller.h
+ * @brief Scan converter that turns a polygon into horizontal spans.
+ *
+ * The filler uses an edge table sorted by the first scanline of every edge and
+ * an active edge list that is stepped incrementally in fixed point, so a fill
+ * costs O(rows * active edges) instead of O(rows * edges). All the storage
+ * (edge table, active list and output spans) is kept between calls, so after
+ * the first few polygons no allocation happens anymore.
+ *
+ * Works for convex and concave polygons (even-odd rule).
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#ifndef GRAPHICS_POLYGON_FILLER_H
+#define GRAPHICS_POLYGON_FILLER_H
+
+#include <stdint.h>
+#include <vector>
+#include "Vec2D.h"
+
+class PolygonFiller {
+public:
+    // Horizontal run of pixels [x0, x1] (both included) on row y
+    struct Span {
+        int y;
+        int x0;
+        int x1;
+    };
+
+    // Instance methods ===================================================== //
+    const std::vector<Span>& scan(const std::vector<Vec2D>& points, int clip_top, int clip_bottom);
+
+private:
+    // 32.32 fixed point x position and slope of an edge
+    struct Edge {
+        int y_start;  // first scanline crossed by the edge
+        int y_end;    // last scanline crossed by the edge
+        int64_t x;
+        int64_t dx;
+    };
+
+    // Instance variables =================================================== //
+    std::vector<Edge> m_edge_table;
+    std::vector<Edge> m_active_edges;
+    std::vector<Span> m_spans;
+};
+
+#endif // GRAPHICS_POLYGON_FILLER_H
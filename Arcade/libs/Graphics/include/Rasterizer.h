@@ -0,0 +1,115 @@
+/**
+ * @file Rasterizer.h
+ * @brief Draws recorded commands into a ScreenBuffer inside a clip rectangle.
+ *
+ * Every pixel a command writes is decided independently of the clip
+ * rectangle, the clip rectangle only selects which of them are written. So a
+ * command drawn tile by tile produces exactly the pixels it produces when
+ * drawn on the whole screen at once, which is what makes the tiled renderer
+ * deterministic.
+ *
+ * Antialiased outlines follow Xiaolin Wu: every step of the line (or of the
+ * circle octant) covers two pixels, weighted by the fractional part of the
+ * exact position in 16.16 fixed point. The weighted pixels of a row are
+ * collected in runs and blended with the SIMD span_blend_pixels() kernel.
+ *
+ * Axis-aligned rectangles with integer corners skip the polygon filler and
+ * the line walker: their fill and outline are written as spans directly.
+ *
+ * Sprites are drawn span by span: opaque spans are copied, translucent ones
+ * blended with span_blend_pixels(), transparent pixels are never visited.
+ * Texts fill the spans of their cached TextRun with the text color.
+ *
+ * The blend mode of the command is switched on once per draw(): every raster
+ * routine below is a template on the mode, so their inner loops call the
+ * pixel and span writers of that mode with no branch.
+ *
+ * The filler scratch storage is kept inside: use one Rasterizer per thread.
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#ifndef GRAPHICS_RASTERIZER_H
+#define GRAPHICS_RASTERIZER_H
+
+#include <SDL2/SDL.h>
+#include <vector>
+#include "BitmapFont.h"
+#include "BlendMode.h"
+#include "Color.h"
+#include "DrawList.h"
+#include "PolygonFiller.h"
+#include "ScreenBuffer.h"
+#include "Sprite.h"
+#include "ThreadPool.h"
+#include "TriangleRasterizer.h"
+#include "Vec2D.h"
+
+class Rasterizer {
+public:
+    // Instance methods ===================================================== //
+    void draw(ScreenBuffer& buffer, const DrawCommand& command, const SDL_Rect& clip, ThreadPool* pool=nullptr);
+
+private:
+    // Contiguous antialiased pixels of one row, waiting to be blended
+    struct CoverageRun {
+        int x0;
+        int y;
+        std::vector<uint32_t> pixels;  // ARGB, alpha scaled by the coverage
+    };
+
+    // Instance variables =================================================== //
+    PolygonFiller m_poly_filler;  // keeps its scratch storage between fills
+    TriangleRasterizer m_triangle_rasterizer;
+    std::vector<Vec2D> m_points;  // polygon corners, reused
+    CoverageRun m_runs[2];  // the two rows crossed by a mostly horizontal line
+
+    // Valid during draw()
+    ScreenBuffer* m_buffer;
+    int m_clip_x0, m_clip_y0, m_clip_x1, m_clip_y1;  // corners included
+
+    // Instance methods ===================================================== //
+    inline bool inside(int x, int y) const {
+        return x >= m_clip_x0 and x <= m_clip_x1 and y >= m_clip_y0 and y <= m_clip_y1;
+    }
+    template <BlendMode M>
+    inline void plot(int x, int y, const Color& color) {
+        if (inside(x, y)) m_buffer->write_pixel<M>(color.get_pixel_color(), x, y);
+    }
+    template <BlendMode M>
+    void span(int x0, int x1, int y, const Color& color);
+
+    // The color with its alpha scaled by coverage / 255
+    static inline uint32_t with_coverage(uint32_t argb, uint32_t coverage) {
+        uint32_t alpha = Color::div_255((argb >> Color::ALPHA_SHIFT) * coverage);
+        return (argb & 0x00FFFFFF) | (alpha << Color::ALPHA_SHIFT);
+    }
+
+    template <BlendMode M>
+    void draw_command(const DrawCommand& command, ThreadPool* pool);
+    template <BlendMode M>
+    void draw_line(float from_x, float from_y, float to_x, float to_y, const Color& color);
+    template <BlendMode M>
+    void draw_line_aa(float from_x, float from_y, float to_x, float to_y, const Color& color);
+    template <BlendMode M>
+    void run_push(CoverageRun& run, int x, int y, uint32_t argb);
+    template <BlendMode M>
+    void run_flush(CoverageRun& run);
+    template <BlendMode M>
+    void draw_rectangle(int x0, int y0, int x1, int y1, const Color& color, bool fill, const Color& fill_color);
+    template <BlendMode M>
+    void fill_poly(const std::vector<Vec2D>& points, const Color& color);
+    template <BlendMode M>
+    void draw_circle_outline(int cx, int cy, int radius, const Color& color);
+    template <BlendMode M>
+    void draw_circle_outline_aa(int cx, int cy, int radius, const Color& color);
+    template <BlendMode M>
+    void fill_circle(int cx, int cy, int radius, const Color& color);
+    template <BlendMode M>
+    void draw_sprite(const Sprite& sprite, int x, int y);
+    template <BlendMode M>
+    void draw_text(const TextRun& run, int x, int y, const Color& color);
+};
+
+#endif // GRAPHICS_RASTERIZER_H
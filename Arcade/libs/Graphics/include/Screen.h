@@ -9,12 +9,28 @@
 
 #include <SDL2/SDL.h>
 #include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
 #include <vector>
+#include "BitmapFont.h"
+#include "BlendMode.h"
 #include "Circle2D.h"
 #include "Color.h"
+#include "DirtyRegion.h"
+#include "DrawList.h"
+#include "FrameRecorder.h"
+#include "FrameStats.h"
+#include "Palette.h"
 #include "Line2D.h"
+#include "Rasterizer.h"
 #include "Rectangle2D.h"
 #include "ScreenBuffer.h"
+#include "Sprite.h"
+#include "ThreadPool.h"
+#include "TripleBuffer.h"
 #include "Triangle2D.h"
 #include "Vec2D.h"
 
@@ -24,17 +40,84 @@ struct SDL_Surface;
 
 class Screen {
 public:
+    // IMMEDIATE: every draw() rasterizes right away
+    // DEFERRED: the draw() calls are recorded and replayed at swap_screens()
+    // TILED: like DEFERRED, but the screen tiles are replayed in parallel on
+    //        the raster thread pool (same pixels as the other modes)
+    enum class RenderMode {IMMEDIATE, DEFERRED, TILED};
+
+    // How frames reach the window
+    // SURFACE: copied into the window surface, magnified on the CPU
+    // RENDERER: uploaded to a streaming texture, magnified by SDL_RenderCopy
+    //           (accelerated renderer if available, software otherwise)
+    enum class Backend {SURFACE, RENDERER};
+
+    // Frames handed over to the render thread
+    struct HandoffStats {
+        uint64_t presented;  // frames taken by the render thread
+        uint64_t dropped;    // overwritten by a newer frame before being taken
+        double last_ms;      // from swap_screens() to the render thread taking it
+        double mean_ms;
+        double max_ms;
+    };
+
     // Constructors ========================================================= //     
     Screen();
 
     // Instance methods ===================================================== //
-    SDL_Window* init(uint32_t w, uint32_t h, uint32_t mag);
+    SDL_Window* init(uint32_t w, uint32_t h, uint32_t mag, Backend backend=Backend::SURFACE, bool vsync=false);
+    bool init_headless(uint32_t w, uint32_t h);  // no window nor video subsystem
     void swap_screens(); // for double-buffering
 
-    inline void set_clear_color(const Color& clr_color) {m_clear_color = clr_color;}
+    // Last presented frame (headless only), for hashing and golden images
+    const ScreenBuffer& frame() const;
+    uint64_t frame_hash() const;
+    bool save_frame(const std::string& path);  // BMP file
+    inline bool is_headless() const {return m_headless;}
+    inline Backend backend() const {return m_backend;}
+    inline double present_ms() const {return m_present_ms;}  // duration of the last present, vsync wait included
+
+    // Present on a dedicated thread (surface backend or headless): swap_screens()
+    // hands the frame over and returns, the next frame is drawn meanwhile.
+    // Headless, the frame() is only stable once the render thread is stopped.
+    void set_render_thread(bool enabled);
+    inline bool has_render_thread() const {return m_render_thread.joinable();}
+    HandoffStats handoff_stats() const;
+
+    // Stream every presented frame to disk (see FrameRecorder): the frame is
+    // copied into a ring on swap_screens(), dropped when the writer is behind
+    bool start_capture(const std::string& path, FrameRecorder::Format format=FrameRecorder::Format::Y4M,
+                       unsigned fps=60);
+    inline void stop_capture() {m_recorder.stop();}
+    inline FrameRecorder::Stats capture_stats() const {return m_recorder.stats();}
+
+    // Counters of the last swap_screens(), zero unless built with GRAPHICS_ENABLE_STATS
+    inline const FrameStats& frame_stats() const {return m_last_frame_stats;}
+    inline void set_allocation_counter(uint64_t (*counter)()) {m_allocation_counter = counter;}  // e.g. from operator new
+    inline void set_stats_overlay(bool enabled) {m_stats_overlay = enabled;}  // frame time bars, top-left
+
+    inline void set_clear_color(const Color& clr_color) {
+        m_clear_color.store(clr_color.get_pixel_color(), std::memory_order_relaxed);
+        m_full_present_pending = true;
+    }
+    void set_raster_threads(unsigned thread_count);  // 0 or 1: single-threaded
+    inline void set_damage_threshold(float fraction) {m_damage_threshold = fraction;}  // of the screen area
+    void set_render_mode(RenderMode mode);
+    void set_palette(std::shared_ptr<const Palette> palette);  // 8-bit indexed back buffer, nullptr: ARGB8888
+    inline void set_antialiasing(bool enabled) {m_antialiasing = enabled;}  // Wu lines and circle outlines
+    // Applied to the next draw calls; OPAQUE ignores the alpha and the antialiasing
+    inline void set_blend_mode(BlendMode mode) {m_blend_mode = mode;}
+    inline BlendMode blend_mode() const {return m_blend_mode;}
+    inline void set_draw_budget(uint64_t pixels) {m_draw_list.set_cost_budget(pixels);}  // deferred only, 0: unlimited
+    inline const DrawList::Stats& draw_stats() const {return m_draw_list.stats();}  // of the last swap_screens()
     inline uint32_t width() const {return m_width;}
     inline uint32_t height() const {return m_height;}
 
+    // Clip rectangle stack: every draw call is clipped to the top rectangle
+    void push_clip_rect(const SDL_Rect& rect);  // intersected with the current one
+    void pop_clip_rect();
+    inline const SDL_Rect& clip_rect() const {return m_clip_stack.back();}
+
     // Draw methods go here
     void draw(int x, int y, const Color& color);
     void draw(const Vec2D& point, const Color& color);
@@ -42,6 +125,10 @@ public:
     void draw(const Triangle2D& triangle, const Color& color, bool fill=false, const Color& fill_color=Color::White());
     void draw(const Rectangle2D& rectangle, const Color& color, bool fill=false, const Color& fill_color=Color::White());
     void draw(const Circle2D& circle, const Color& color, bool fill=false, const Color& fill_color=Color::White());
+    // Top-left corner at (x, y); the atlas must be packed and outlive the frame
+    void draw(const Sprite& sprite, int x, int y);
+    // Top-left corner at (x, y); laid out once per string by the font cache
+    void draw(BitmapFont& font, const std::string& text, int x, int y, const Color& color);
 
     // Destructor =========================================================== //
     ~Screen();
@@ -50,12 +137,66 @@ private:
     // Instance variables =================================================== //
     uint32_t m_width;
     uint32_t m_height;
+    uint32_t m_magnification;
 
-    Color m_clear_color;  // to clear every frame
+    std::atomic<uint32_t> m_clear_color;  // ARGB, to clear every frame (read by the render thread too)
     ScreenBuffer m_back_buffer;  // for dobule-buffering 
+    ScreenBuffer m_front_buffer;  // presented frame when headless
+    std::shared_ptr<const Palette> m_palette;  // of the indexed back buffer, if any
+    Rasterizer m_rasterizer;
+    std::unique_ptr<ThreadPool> m_thread_pool;  // for large fills and tiles (optional)
 
+    // Deferred drawing: commands are recorded and replayed at swap_screens()
+    DrawList m_draw_list;
+    std::vector<Rasterizer> m_tile_rasterizers;  // one per pool thread
+    std::vector<std::shared_ptr<const TextRun>> m_texts;  // of the recorded text commands
+    RenderMode m_render_mode;
+    bool m_antialiasing;
+    BlendMode m_blend_mode;  // of the next draw calls
+
+    std::vector<SDL_Rect> m_clip_stack;  // the bottom one is the whole screen
+
+    // Damage tracking: only the changed parts of the window are presented
+    DirtyRegion m_damage;           // drawn during this frame
+    DirtyRegion m_previous_damage;  // drawn during the previous frame (to erase)
+    DirtyRegion m_present_region;   // union of the two, reused every frame
+    std::vector<SDL_Rect> m_window_rects;
+    float m_damage_threshold;       // above this fraction of the screen: full present
+    bool m_full_present_pending;    // game thread only
+
+    bool m_initialized;
+    bool m_headless;
     SDL_Window* m_window_ptr;
     SDL_Surface* m_window_surface_ptr;
+    bool m_direct_present;  // window surface in the back buffer layout: scale_nearest() instead of SDL_BlitScaled
+
+    // Renderer backend
+    Backend m_backend;
+    SDL_Renderer* m_renderer_ptr;
+    SDL_Texture* m_texture_ptr;  // streaming, back buffer size and format
+    std::atomic<double> m_present_ms;
+
+    // Render thread: it owns the window while running
+    std::unique_ptr<TripleBuffer<ScreenBuffer>> m_frames;
+    std::thread m_render_thread;
+    std::atomic<bool> m_render_thread_running;
+    std::atomic<uint32_t> m_published_frames;  // the render thread sleeps on it
+    std::atomic<uint64_t> m_presented_frames;
+    std::atomic<uint64_t> m_dropped_frames;
+    std::atomic<int64_t> m_handoff_last_ns;
+    std::atomic<int64_t> m_handoff_max_ns;
+    std::atomic<int64_t> m_handoff_total_ns;
+
+    FrameRecorder m_recorder;  // frame capture, when started
+
+    // Frame statistics (collected with GRAPHICS_ENABLE_STATS)
+    FrameStats m_frame_stats;       // of the frame being drawn
+    FrameStats m_last_frame_stats;  // of the last swap_screens()
+    double m_render_thread_update_ms;  // the render thread updates are not timed in a frame
+    uint64_t (*m_allocation_counter)();
+    uint64_t m_allocations_start;
+    std::chrono::steady_clock::time_point m_last_swap;
+    bool m_stats_overlay;
 
     // Constructors ========================================================= //
 
@@ -63,8 +204,27 @@ private:
     Screen(const Screen& other_screen); // copy constructor NOT allowed to be used from anyone
     
     // Instance methods ===================================================== //
-    void fill_poly(const std::vector<Vec2D>& points, const Color& color);
-    void clear_screen();
+    void init_buffers();
+    void init_frame_buffer(ScreenBuffer& buffer);
+    void submit(DrawCommand command);
+    void flush_draw_list();
+    void raster(const DrawCommand& command);
+    inline Color clear_color() const {return Color(m_clear_color.load(std::memory_order_relaxed));}
+    void clear_screen(const SDL_Rect* rect=nullptr);
+    void present_full();
+    void present_frame(ScreenBuffer& frame);
+    void hand_over_frame();
+    void render_loop();
+    void end_frame_stats();
+    void draw_stats_overlay();
+    inline double& update_ms_counter() {return m_render_thread_running ? m_render_thread_update_ms : m_frame_stats.update_ms;}
+    void present_damage();
+    void present_damage_to_window();
+    bool window_matches_back_buffer();
+    bool init_renderer(bool vsync);
+    void upload_to_texture(ScreenBuffer& frame, const SDL_Rect& rect);
+    void render_texture();
+    void scale_to_window(ScreenBuffer& frame, const SDL_Rect& rect);
 
     // Operator overloading ================================================= //
 
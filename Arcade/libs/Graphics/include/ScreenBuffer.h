@@ -10,40 +10,128 @@
 
 #include <SDL2/SDL.h>
 #include <stdint.h>
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include "BlendMode.h"
 #include "Color.h"
+#include "Palette.h"
 
 class Color;
 // struct SDL_surface;  // a SDL surface can be view as a big pixel buffer
 
 /**
- * //todo
+ * An ARGB8888 (or 8-bit indexed) pixel buffer on an SDL surface. Surfaces
+ * come from SurfacePool::shared() and go back to it, so buffers created and
+ * dropped every frame reuse their pixels. Buffers are meant to be moved:
+ * every copy is a deep copy, counted by deep_copies().
  */
 class ScreenBuffer {
 public:
+    // Class methods ======================================================== //
+    static inline uint64_t deep_copies() {return s_deep_copies.load(std::memory_order_relaxed);}
+
     // Constructors ========================================================= //
     ScreenBuffer();
-    ScreenBuffer(const ScreenBuffer& screen_buff); // copy constructor
+    ScreenBuffer(const ScreenBuffer& screen_buff); // copy constructor (deep)
+    ScreenBuffer(ScreenBuffer&& screen_buff) noexcept; // move constructor
 
     // Instance methods ===================================================== //
     void init(uint32_t width, uint32_t height, bool alpha_channel=true);
+    // 8-bit indexed pixels: colors are mapped to the palette, translucency
+    // goes through its blend table. Only the uint8_t rows can be accessed.
+    void init_indexed(uint32_t width, uint32_t height, std::shared_ptr<const Palette> palette);
+    inline bool is_indexed() const {return m_palette != nullptr;}
+    inline const Palette* palette() const {return m_palette.get();}
     inline SDL_Surface* get_surface() {return m_surface_ptr;}
+    inline int width() const {return m_surface_ptr ? m_surface_ptr->w : 0;}
+    inline int height() const {return m_surface_ptr ? m_surface_ptr->h : 0;}
+    inline int pitch() const {return m_surface_ptr ? m_surface_ptr->pitch : 0;}  // bytes per row
     void clear_surface(const Color& c=Color::Black());
     void set_pixel(const Color& c, int x, int y);
 
+    // Frame-scoped write access: the surface is locked once in begin_frame()
+    // and every write until end_frame() goes straight to the pixel rows.
+    void begin_frame();
+    void end_frame();
+    inline bool in_frame() const {return m_in_frame;}
+    inline uint32_t* get_row(int y) {
+        return reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(m_surface_ptr->pixels) + y * m_surface_ptr->pitch);
+    }
+    inline const uint32_t* get_row(int y) const {
+        return reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(m_surface_ptr->pixels) + y * m_surface_ptr->pitch);
+    }
+    inline uint8_t* get_index_row(int y) {
+        return static_cast<uint8_t*>(m_surface_ptr->pixels) + y * m_surface_ptr->pitch;
+    }
+    inline const uint8_t* get_index_row(int y) const {
+        return static_cast<const uint8_t*>(m_surface_ptr->pixels) + y * m_surface_ptr->pitch;
+    }
+    inline bool contains(int x, int y) const {
+        return x >= 0 and y >= 0 and x < m_surface_ptr->w and y < m_surface_ptr->h;
+    }
+
+    // Span writers: [x0, x1] inclusive on row y, clipped to the surface
+    void fill_span(int x0, int x1, int y, const Color& c);   // opaque copy
+    inline void blend_span(int x0, int x1, int y, const Color& c) {  // alpha blending
+        write_span<BlendMode::SOURCE_OVER>(x0, x1, y, c.get_pixel_color());
+    }
+    template <BlendMode M>
+    void write_span(int x0, int x1, int y, uint32_t argb);  // instantiated for every mode
+
+    void copy_rect(const ScreenBuffer& source, const SDL_Rect& rect);  // no blending, indexed pixels are expanded
+    void swap(ScreenBuffer& other) noexcept;  // exchange the surfaces, no pixel is copied
+
+    /**
+     * Blend a single pixel without any checks: the caller must be inside a
+     * frame and the (x, y) position must be inside the surface.
+     */
+    inline void blend_pixel(const Color& c, int x, int y) {
+        write_pixel<BlendMode::SOURCE_OVER>(c.get_pixel_color(), x, y);
+    }
+    template <BlendMode M>
+    inline void write_pixel(uint32_t argb, int x, int y) {
+        if (m_palette) {
+            uint8_t* index = get_index_row(y) + x;
+            *index = blend_index<M>(argb, *index);
+            return;
+        }
+        uint32_t* pixel = get_row(y) + x;
+        *pixel = blend_argb<M>(argb, *pixel);
+    }
+
     // Operator overloading ================================================= //
-    ScreenBuffer& operator=(const ScreenBuffer& ScreenBuffer);
+    ScreenBuffer& operator=(const ScreenBuffer& ScreenBuffer);  // deep
+    ScreenBuffer& operator=(ScreenBuffer&& screen_buff) noexcept;
 
     // Destructor =========================================================== //
     ~ScreenBuffer();
 
 private:
+    // Class variables ====================================================== //
+    static std::atomic<uint64_t> s_deep_copies;
+
     // Instance variables =================================================== //
     SDL_Surface* m_surface_ptr;
+    std::shared_ptr<const Palette> m_palette;  // indexed mode only
     size_t m_surface_area;
+    bool m_in_frame;
 
     // Instance methods ===================================================== //
-    size_t get_index(int row, int col);
+    void release_surface();
+
+    // The indexed destination pixel blended in RGB and mapped back to the palette
+    template <BlendMode M>
+    inline uint8_t blend_index(uint32_t argb, uint8_t index) const {
+        if constexpr (M == BlendMode::OPAQUE) {
+            return m_palette->index_of(argb);
+        } else if constexpr (M == BlendMode::SOURCE_OVER) {
+            return m_palette->blend(argb, index);  // through the blend table
+        } else {
+            return m_palette->index_of(blend_argb<M>(argb, m_palette->color(index)));
+        }
+    }
+    void copy_from(const ScreenBuffer& other);
 };
 
 #endif // GRAPHICS_SCREEN_BUFFER_H
\ No newline at end of file
@@ -0,0 +1,119 @@
+/**
+ * @file Sprite.h
+ * @brief Bitmaps packed into a SpriteAtlas and blitted by the Screen.
+ *
+ * Sprites are loaded once (SDL_LoadBMP or any SDL surface), converted to
+ * ARGB8888 and copied into a single atlas surface by pack(), which places
+ * them on shelves: sorted by height, left to right in rows as tall as their
+ * first sprite, the atlas width being the smallest power of two that keeps
+ * the height under MAX_SIZE.
+ *
+ * Every row of a sprite is stored as run-length spans of visible pixels, so
+ * transparent pixels are never visited by the blitter:
+ * - OPAQUE: one span per row, copied.
+ * - COLOR_KEY: the pixels of the key color (RGB) are skipped, the others
+ *   copied.
+ * - ALPHA: alpha 0 is skipped, alpha 255 copied, the rest alpha blended with
+ *   span_blend_pixels().
+ *
+ * A Sprite lives in its atlas: the atlas has to outlive every frame the
+ * sprite is drawn in (deferred commands only keep a pointer).
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#ifndef GRAPHICS_SPRITE_H
+#define GRAPHICS_SPRITE_H
+
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Color.h"
+
+class Sprite {
+public:
+    enum class BlitMode : uint8_t {OPAQUE, COLOR_KEY, ALPHA};
+
+    // Visible pixels [x, x + length) of a row, x relative to the sprite
+    struct Span {
+        uint16_t x;
+        uint16_t length;
+        bool blend;  // translucent pixels (ALPHA only), copied otherwise
+    };
+
+    // Constructors ========================================================= //
+    Sprite();
+
+    // Instance methods ===================================================== //
+    inline int width() const {return m_rect.w;}
+    inline int height() const {return m_rect.h;}
+    inline BlitMode mode() const {return m_mode;}
+    inline const SDL_Rect& atlas_rect() const {return m_rect;}
+    inline uint64_t visible_pixels() const {return m_visible_pixels;}
+    inline bool has_blending() const {return m_blending;}  // any translucent pixel
+
+    inline bool is_packed() const {return m_pixels != nullptr;}  // pixels in a packed atlas
+
+    // Valid once the atlas is packed
+    inline const uint32_t* row_pixels(int row) const {return m_pixels + static_cast<size_t>(row) * m_pitch;}
+    inline const Span* spans_begin(int row) const {return m_spans.data() + m_row_start[row];}
+    inline const Span* spans_end(int row) const {return m_spans.data() + m_row_start[row + 1];}
+
+private:
+    friend class SpriteAtlas;
+
+    // Instance variables =================================================== //
+    SDL_Rect m_rect;  // in the atlas
+    BlitMode m_mode;
+    uint32_t m_key;   // RGB of the transparent color (COLOR_KEY)
+    const uint32_t* m_pixels;  // top-left pixel in the atlas
+    size_t m_pitch;            // in pixels
+    std::vector<Span> m_spans;
+    std::vector<uint32_t> m_row_start;  // row r holds m_spans[start[r], start[r + 1])
+    uint64_t m_visible_pixels;
+    bool m_blending;
+
+    // Instance methods ===================================================== //
+    void build_spans();
+};
+
+class SpriteAtlas {
+public:
+    // Class variables ====================================================== //
+    static constexpr int MAX_SIZE = 4096;  // atlas side, in pixels
+
+    // Constructors ========================================================= //
+    SpriteAtlas();
+
+    // Instance methods ===================================================== //
+    // Sprite ids, -1 on failure. Only before pack(); the surface is not taken.
+    int load_bmp(const std::string& path, Sprite::BlitMode mode, const Color& key=Color::Magenta());
+    int add(SDL_Surface* surface, Sprite::BlitMode mode, const Color& key=Color::Magenta());
+
+    bool pack();  // false when the sprites do not fit in MAX_SIZE x MAX_SIZE
+    inline bool is_packed() const {return m_atlas_ptr != nullptr;}
+
+    inline const Sprite& operator[](int id) const {return m_sprites[id];}
+    inline size_t size() const {return m_sprites.size();}
+    inline const SDL_Surface* get_surface() const {return m_atlas_ptr;}
+
+    // Destructor =========================================================== //
+    ~SpriteAtlas();
+
+private:
+    // Instance variables =================================================== //
+    std::vector<Sprite> m_sprites;
+    std::vector<SDL_Surface*> m_sources;  // ARGB8888 copies, until pack()
+    SDL_Surface* m_atlas_ptr;
+
+    // Instance methods ===================================================== //
+    bool place(int atlas_width, const std::vector<int>& order, int& atlas_height);
+
+    // Copy is NOT allowed
+    SpriteAtlas(const SpriteAtlas& other)=delete;
+    SpriteAtlas& operator=(const SpriteAtlas& other)=delete;
+};
+
+#endif // GRAPHICS_SPRITE_H
@@ -0,0 +1,67 @@
+/**
+ * @file SurfacePool.h
+ * @brief Recycles SDL surfaces of the same size and pixel format.
+ *
+ * Released surfaces are kept, per (width, height, format), and handed out
+ * again by acquire() instead of allocating new pixels: offscreen buffers,
+ * layers and frame snapshots created and dropped every frame reuse the same
+ * few allocations. The content of a recycled surface is undefined.
+ *
+ * The pool is thread-safe: surfaces may be released by the render thread.
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#ifndef GRAPHICS_SURFACE_POOL_H
+#define GRAPHICS_SURFACE_POOL_H
+
+#include <SDL2/SDL.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+class SurfacePool {
+public:
+    // Class variables ====================================================== //
+    static constexpr size_t MAX_FREE_PER_KEY = 8;  // beyond, released surfaces are freed
+
+    struct Stats {
+        uint64_t allocated;  // new surfaces
+        uint64_t reused;     // surfaces taken from the pool
+        size_t free;         // surfaces waiting in the pool
+    };
+
+    // Class methods ======================================================== //
+    static SurfacePool& shared();  // used by every ScreenBuffer
+
+    // Constructors ========================================================= //
+    SurfacePool();
+
+    // Instance methods ===================================================== //
+    SDL_Surface* acquire(int width, int height, uint32_t format);  // nullptr if SDL fails
+    void release(SDL_Surface* surface);
+    void clear();  // free every pooled surface
+    Stats stats() const;
+
+    // Destructor =========================================================== //
+    ~SurfacePool();
+
+private:
+    using Key = std::tuple<int, int, uint32_t>;  // width, height, format
+
+    // Instance variables =================================================== //
+    mutable std::mutex m_mutex;
+    std::map<Key, std::vector<SDL_Surface*>> m_free;
+    uint64_t m_allocated;
+    uint64_t m_reused;
+
+    // Copy is NOT allowed
+    SurfacePool(const SurfacePool& other)=delete;
+    SurfacePool& operator=(const SurfacePool& other)=delete;
+};
+
+#endif // GRAPHICS_SURFACE_POOL_H
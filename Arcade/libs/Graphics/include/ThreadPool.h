@@ -0,0 +1,62 @@
+/**
+ * @file ThreadPool.h
+ * @brief Fixed pool of worker threads running parallel-for loops.
+ *
+ * The pool is created once and its workers sleep between jobs. A job is a
+ * parallel_for(): the indices [0, count) are handed out one at a time to the
+ * workers and to the calling thread, and the call returns when every index
+ * has been processed. Tasks that need per-thread scratch storage can take the
+ * index of the thread running them, in [0, size()).
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#ifndef GRAPHICS_THREAD_POOL_H
+#define GRAPHICS_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    // Constructors ========================================================= //
+    explicit ThreadPool(unsigned thread_count);
+
+    // Instance methods ===================================================== //
+    inline unsigned size() const {return static_cast<unsigned>(m_workers.size()) + 1;}  // workers + caller
+    void parallel_for(size_t count, const std::function<void(size_t)>& task);
+    void parallel_for(size_t count, const std::function<void(size_t, unsigned)>& task);  // (index, thread)
+
+    // Destructor =========================================================== //
+    ~ThreadPool();
+
+private:
+    // Instance variables =================================================== //
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_start_cv;
+    std::condition_variable m_done_cv;
+
+    const std::function<void(size_t, unsigned)>* m_task;
+    size_t m_count;
+    std::atomic<size_t> m_next_index;
+    unsigned m_busy_workers;
+    uint64_t m_generation;  // incremented for every job
+    bool m_stop;
+
+    // Instance methods ===================================================== //
+    void worker_loop(unsigned thread_index);
+    void run_tasks(unsigned thread_index);
+
+    // Copy is NOT allowed
+    ThreadPool(const ThreadPool& other)=delete;
+    ThreadPool& operator=(const ThreadPool& other)=delete;
+};
+
+#endif // GRAPHICS_THREAD_POOL_H
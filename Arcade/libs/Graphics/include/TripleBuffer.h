@@ -0,0 +1,84 @@
+/**
+ * @file TripleBuffer.h
+ * @brief Lock-free single-producer single-consumer triple buffer.
+ *
+ * Three slots: the producer writes the back one, the consumer reads the front
+ * one and the third (the middle) holds the latest published frame. publish()
+ * and acquire() are a single atomic exchange of slot indices, so neither side
+ * ever waits for the other: a producer faster than the consumer overwrites
+ * the unread middle frame (it is dropped), a slower one lets the consumer
+ * keep its front frame.
+ *
+ * Every publish() is timestamped, acquire() measures the handoff latency.
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#ifndef GRAPHICS_TRIPLE_BUFFER_H
+#define GRAPHICS_TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+
+template <typename T>
+class TripleBuffer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Constructors ========================================================= //
+    TripleBuffer() : m_back(0), m_middle(1), m_front(2), m_handoff_latency(0) {}
+
+    // Instance methods ===================================================== //
+    // Producer side
+    inline T& back() {return m_slots[m_back];}
+    /**
+     * Hand the back slot over to the consumer and take the middle one as the
+     * new back. Returns false when the frame published before was never
+     * acquired (it has been dropped).
+     */
+    bool publish() {
+        m_published_at[m_back] = Clock::now();
+        uint32_t previous = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel);
+        m_back = previous & INDEX_MASK;
+        return !(previous & FRESH);
+    }
+
+    // Consumer side
+    inline T& front() {return m_slots[m_front];}
+    /**
+     * Take the latest published frame as the new front, if there is one
+     * newer than the current front.
+     */
+    bool acquire() {
+        if (!(m_middle.load(std::memory_order_relaxed) & FRESH)) return false;
+
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+        m_handoff_latency = Clock::now() - m_published_at[m_front];
+        return true;
+    }
+    inline Clock::duration handoff_latency() const {return m_handoff_latency;}  // of the last acquire()
+
+    // All the slots, to set them up before the two sides start
+    inline T& slot(unsigned index) {return m_slots[index];}
+
+private:
+    // Class variables ====================================================== //
+    static constexpr uint32_t INDEX_MASK = 0x3;
+    static constexpr uint32_t FRESH = 0x4;  // the middle slot has not been acquired yet
+
+    // Instance variables =================================================== //
+    T m_slots[3];
+    Clock::time_point m_published_at[3];  // written before the release of publish()
+    uint32_t m_back;                 // producer only
+    std::atomic<uint32_t> m_middle;  // slot index | FRESH
+    uint32_t m_front;                // consumer only
+    Clock::duration m_handoff_latency;
+
+    // Copy is NOT allowed
+    TripleBuffer(const TripleBuffer& other)=delete;
+    TripleBuffer& operator=(const TripleBuffer& other)=delete;
+};
+
+#endif // GRAPHICS_TRIPLE_BUFFER_H
@@ -1,7 +1,7 @@
 #ifndef GRAPHICS_UTILS_H
 #define GRAPHICS_UTILS_H
 
-// TODO: create docstring
+// Segments of the polygon approximating a circle of the given radius (at least 3)
 unsigned int calculate_number_of_segments(float radius);
 
-#endif  // GRAPHICS_UTILS_H
\ No newline at end of file
+#endif  // GRAPHICS_UTILS_H
@@ -0,0 +1,41 @@
+/**
+ * @file pixel_scale.h
+ * @brief Integer-factor nearest-neighbour magnification of 32 bit pixels.
+ *
+ * Used to present the back buffer on a window `factor` times larger: every
+ * source row is read once and widened into the first of its destination rows
+ * (SSE2 shuffles for the factors 2 to 4), which is then copied to the other
+ * factor - 1 rows with memcpy. Pixels are copied as they are, so source and
+ * destination must share the same 32 bit layout.
+ *
+ * 8-bit indexed sources are expanded through their ARGB palette on the fly,
+ * in the same single pass.
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#ifndef GRAPHICS_PIXEL_SCALE_H
+#define GRAPHICS_PIXEL_SCALE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Magnify the w x h rectangle at (x, y) of src into dst at (x * factor,
+ * y * factor). Pitches are in bytes; no clipping is done.
+ */
+void scale_nearest(const void* src, int src_pitch, void* dst, int dst_pitch,
+                   int x, int y, int w, int h, int factor);
+
+/**
+ * Same as scale_nearest() for a source of palette indices (one byte per
+ * pixel), written as the ARGB colors of the palette (256 entries).
+ */
+void scale_nearest_indexed(const void* src, int src_pitch, const uint32_t* palette, void* dst, int dst_pitch,
+                           int x, int y, int w, int h, int factor);
+
+// Write the ARGB colors of count palette indices
+void expand_indexed(const uint8_t* src, const uint32_t* palette, uint32_t* dst, int count);
+
+#endif  // GRAPHICS_PIXEL_SCALE_H
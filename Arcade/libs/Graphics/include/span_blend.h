@@ -0,0 +1,32 @@
+/**
+ * @file span_blend.h
+ * @brief Alpha blending kernels for horizontal runs of ARGB8888 pixels.
+ *
+ * Every kernel evaluates (a * s + (255 - a) * d) / 255 per channel in integer
+ * fixed point, exactly like Color::alpha_blending, and writes opaque pixels.
+ * The public entry points dispatch at runtime to an AVX2 or SSE2 version when
+ * the CPU supports it; the *_scalar versions are the bit-exact reference.
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#ifndef GRAPHICS_SPAN_BLEND_H
+#define GRAPHICS_SPAN_BLEND_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Blend one constant ARGB color over count destination pixels
+void span_blend_solid(uint32_t* dst, size_t count, uint32_t argb);
+// Blend count per-pixel ARGB source colors over count destination pixels
+void span_blend_pixels(uint32_t* dst, const uint32_t* src, size_t count);
+
+// Scalar reference kernels
+void span_blend_solid_scalar(uint32_t* dst, size_t count, uint32_t argb);
+void span_blend_pixels_scalar(uint32_t* dst, const uint32_t* src, size_t count);
+
+// Name of the instruction set picked by the runtime dispatch
+const char* span_blend_isa();
+
+#endif  // GRAPHICS_SPAN_BLEND_H
@@ -0,0 +1,252 @@
+/**
+ * @file BitmapFont.cpp
+ * @brief Bitmap fonts drawn as pre-rendered, cached text spans.
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <iostream>
+#include "BitmapFont.h"
+
+namespace {
+
+constexpr int GLYPH_COUNT = BitmapFont::LAST_CHAR - BitmapFont::FIRST_CHAR + 1;
+constexpr int FONT_WIDTH = 5;
+constexpr int FONT_HEIGHT = 7;
+
+// The classic 5x7 ASCII font, ' ' to '~': one byte per column, bit 0 on top
+constexpr uint8_t FONT_5X7[GLYPH_COUNT][FONT_WIDTH] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00},  //   ! "
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},  // # $ %
+    {0x36, 0x49, 0x55, 0x22, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00}, {0x00, 0x1C, 0x22, 0x41, 0x00},  // & ' (
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x14, 0x08, 0x3E, 0x08, 0x14}, {0x08, 0x08, 0x3E, 0x08, 0x08},  // ) * +
+    {0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x60, 0x60, 0x00, 0x00},  // , - .
+    {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00},  // / 0 1
+    {0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4B, 0x31}, {0x18, 0x14, 0x12, 0x7F, 0x10},  // 2 3 4
+    {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03},  // 5 6 7
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x36, 0x36, 0x00, 0x00},  // 8 9 :
+    {0x00, 0x56, 0x36, 0x00, 0x00}, {0x08, 0x14, 0x22, 0x41, 0x00}, {0x14, 0x14, 0x14, 0x14, 0x14},  // ; < =
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x51, 0x09, 0x06}, {0x32, 0x49, 0x79, 0x41, 0x3E},  // > ? @
+    {0x7E, 0x11, 0x11, 0x11, 0x7E}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},  // A B C
+    {0x7F, 0x41, 0x41, 0x22, 0x1C}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x09, 0x01},  // D E F
+    {0x3E, 0x41, 0x49, 0x49, 0x7A}, {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00},  // G H I
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41}, {0x7F, 0x40, 0x40, 0x40, 0x40},  // J K L
+    {0x7F, 0x02, 0x0C, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},  // M N O
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46},  // P Q R
+    {0x46, 0x49, 0x49, 0x49, 0x31}, {0x01, 0x01, 0x7F, 0x01, 0x01}, {0x3F, 0x40, 0x40, 0x40, 0x3F},  // S T U
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x3F, 0x40, 0x38, 0x40, 0x3F}, {0x63, 0x14, 0x08, 0x14, 0x63},  // V W X
+    {0x07, 0x08, 0x70, 0x08, 0x07}, {0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x00},  // Y Z [
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x7F, 0x00}, {0x04, 0x02, 0x01, 0x02, 0x04},  // \ ] ^
+    {0x40, 0x40, 0x40, 0x40, 0x40}, {0x00, 0x01, 0x02, 0x04, 0x00}, {0x20, 0x54, 0x54, 0x54, 0x78},  // _ ` a
+    {0x7F, 0x48, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x20}, {0x38, 0x44, 0x44, 0x48, 0x7F},  // b c d
+    {0x38, 0x54, 0x54, 0x54, 0x18}, {0x08, 0x7E, 0x09, 0x01, 0x02}, {0x0C, 0x52, 0x52, 0x52, 0x3E},  // e f g
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x44, 0x3D, 0x00},  // h i j
+    {0x7F, 0x10, 0x28, 0x44, 0x00}, {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x18, 0x04, 0x78},  // k l m
+    {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38}, {0x7C, 0x14, 0x14, 0x14, 0x08},  // n o p
+    {0x08, 0x14, 0x14, 0x18, 0x7C}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x20},  // q r s
+    {0x04, 0x3F, 0x44, 0x40, 0x20}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C},  // t u v
+    {0x3C, 0x40, 0x30, 0x40, 0x3C}, {0x44, 0x28, 0x10, 0x28, 0x44}, {0x0C, 0x50, 0x50, 0x50, 0x3C},  // w x y
+    {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00}, {0x00, 0x00, 0x7F, 0x00, 0x00},  // z { |
+    {0x00, 0x41, 0x36, 0x08, 0x00}, {0x08, 0x04, 0x08, 0x10, 0x08},                                  // } ~
+};
+
+// A span of ink on one row of the text, before sorting and merging
+struct Piece {
+    int row;
+    int x;
+    int length;
+};
+
+}  // namespace
+
+// ========================================================================== //
+// Public interface                                                           //
+// ========================================================================== //
+
+// Constructors ============================================================= //
+
+BitmapFont::BitmapFont(Spacing spacing) : m_spacing(spacing), m_cell_width(FONT_WIDTH), m_cell_height(FONT_HEIGHT),
+                                          m_letter_spacing(1), m_line_spacing(1),
+                                          m_atlas_width(GLYPH_COUNT * FONT_WIDTH) {
+    m_atlas.assign(static_cast<size_t>(m_atlas_width) * m_cell_height, 0);
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        for (int column = 0; column < FONT_WIDTH; column++) {
+            for (int row = 0; row < FONT_HEIGHT; row++) {
+                m_atlas[row * m_atlas_width + i * FONT_WIDTH + column] = (FONT_5X7[i][column] >> row) & 1;
+            }
+        }
+    }
+    build_glyphs();
+}
+
+// Instance methods ========================================================= //
+
+bool BitmapFont::load_bmp(const std::string& path, int cell_width, int cell_height) {
+    if (cell_width <= 0 or cell_height <= 0) return false;
+
+    SDL_Surface* bmp = SDL_LoadBMP(path.c_str());
+    if (!bmp) {
+        std::cerr << "Error: Failed to load " << path << ": " << SDL_GetError() << std::endl;
+        return false;
+    }
+    SDL_Surface* sheet = SDL_ConvertSurfaceFormat(bmp, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(bmp);
+    if (!sheet) {
+        std::cerr << "Error: Failed to convert " << path << ": " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    int columns = sheet->w / cell_width;
+    if (columns * (sheet->h / cell_height) < GLYPH_COUNT) {
+        std::cerr << "Error: " << path << " holds less than " << GLYPH_COUNT << " glyphs" << std::endl;
+        SDL_FreeSurface(sheet);
+        return false;
+    }
+
+    m_cell_width = cell_width;
+    m_cell_height = cell_height;
+    m_atlas_width = GLYPH_COUNT * cell_width;
+    m_atlas.assign(static_cast<size_t>(m_atlas_width) * cell_height, 0);
+
+    if (SDL_MUSTLOCK(sheet)) SDL_LockSurface(sheet);
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        int cell_x = (i % columns) * cell_width;
+        int cell_y = (i / columns) * cell_height;
+        for (int row = 0; row < cell_height; row++) {
+            const uint32_t* pixels = reinterpret_cast<const uint32_t*>(
+                static_cast<const uint8_t*>(sheet->pixels) + (cell_y + row) * sheet->pitch) + cell_x;
+            for (int column = 0; column < cell_width; column++) {
+                m_atlas[row * m_atlas_width + i * cell_width + column] = (pixels[column] & 0x00FFFFFF) != 0;
+            }
+        }
+    }
+    if (SDL_MUSTLOCK(sheet)) SDL_UnlockSurface(sheet);
+    SDL_FreeSurface(sheet);
+
+    build_glyphs();
+    m_cache.clear();
+    return true;
+}
+
+int BitmapFont::advance(char c) const {
+    return std::max(glyph(c).width + m_letter_spacing, 0);
+}
+
+std::shared_ptr<const TextRun> BitmapFont::layout(const std::string& text) {
+    auto cached = m_cache.find(text);
+    if (cached != m_cache.end()) return cached->second;
+
+    if (m_cache.size() >= MAX_CACHED_TEXTS) m_cache.clear();
+    std::shared_ptr<const TextRun> run = render(text);
+    m_cache.emplace(text, run);
+    return run;
+}
+
+// ========================================================================== //
+// Private interface                                                          //
+// ========================================================================== //
+
+// Instance methods ========================================================= //
+
+/**
+ * Proportional glyphs are trimmed to their ink columns; glyphs without ink
+ * (the space) keep half a cell
+ */
+void BitmapFont::build_glyphs() {
+    m_glyphs.resize(GLYPH_COUNT);
+
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        Glyph& glyph = m_glyphs[i];
+        glyph.atlas_x = i * m_cell_width;
+        glyph.ink_x0 = 0;
+        glyph.width = m_cell_width;
+        if (m_spacing == Spacing::FIXED) continue;
+
+        int first = m_cell_width, last = -1;
+        for (int column = 0; column < m_cell_width; column++) {
+            for (int row = 0; row < m_cell_height; row++) {
+                if (m_atlas[row * m_atlas_width + glyph.atlas_x + column]) {
+                    first = std::min(first, column);
+                    last = column;
+                }
+            }
+        }
+
+        if (last < 0) {
+            glyph.width = std::max(1, m_cell_width / 2);
+        } else {
+            glyph.ink_x0 = first;
+            glyph.width = last - first + 1;
+        }
+    }
+}
+
+const BitmapFont::Glyph& BitmapFont::glyph(char c) const {
+    if (c < FIRST_CHAR or c > LAST_CHAR) c = '?';
+    return m_glyphs[c - FIRST_CHAR];
+}
+
+/**
+ * Every glyph row adds its runs of ink at the pen position; the runs are then
+ * sorted by row and the ones touching or overlapping across glyphs merged, so
+ * no pixel is covered twice
+ */
+std::shared_ptr<const TextRun> BitmapFont::render(const std::string& text) const {
+    std::vector<Piece> pieces;
+    int pen_x = 0, line_y = 0, width = 0;
+
+    for (char c : text) {
+        if (c == '\n') {
+            pen_x = 0;
+            line_y += std::max(m_cell_height + m_line_spacing, 0);
+            continue;
+        }
+
+        const Glyph& g = glyph(c);
+        for (int row = 0; row < m_cell_height; row++) {
+            const uint8_t* mask = m_atlas.data() + row * m_atlas_width + g.atlas_x + g.ink_x0;
+            int column = 0;
+            while (column < g.width) {
+                if (!mask[column]) {
+                    column++;
+                    continue;
+                }
+                int end = column + 1;
+                while (end < g.width and mask[end]) end++;
+                pieces.push_back({line_y + row, pen_x + column, end - column});
+                column = end;
+            }
+        }
+
+        width = std::max(width, pen_x + g.width);
+        pen_x += std::max(g.width + m_letter_spacing, 0);
+    }
+
+    std::sort(pieces.begin(), pieces.end(), [](const Piece& a, const Piece& b) {
+        return a.row != b.row ? a.row < b.row : a.x < b.x;
+    });
+
+    auto run = std::make_shared<TextRun>();
+    run->width = width;
+    run->height = line_y + m_cell_height;
+    run->row_start.assign(run->height + 1, 0);
+    run->pixels = 0;
+
+    // Pieces touching or overlapping (negative spacing) on a row become one span
+    for (size_t i = 0; i < pieces.size(); i++) {
+        const Piece& piece = pieces[i];
+        TextRun::Span* back = run->spans.empty() ? nullptr : &run->spans.back();
+        if (i > 0 and pieces[i - 1].row == piece.row and piece.x <= back->x + back->length) {
+            back->length = std::max(back->length, piece.x + piece.length - back->x);
+        } else {
+            run->spans.push_back({piece.x, piece.length});
+            run->row_start[piece.row + 1]++;
+        }
+    }
+    for (const TextRun::Span& span : run->spans) run->pixels += span.length;
+    for (int row = 0; row < run->height; row++) run->row_start[row + 1] += run->row_start[row];
+
+    return run;
+}
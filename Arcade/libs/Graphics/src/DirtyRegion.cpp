@@ -0,0 +1,102 @@
+/**
+ * @file DirtyRegion.cpp
+ * @brief Set of damaged rectangles of the screen.
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#include <algorithm>
+#include "DirtyRegion.h"
+
+namespace {
+
+// True when the two rectangles overlap or share a border
+inline bool touches(const SDL_Rect& a, const SDL_Rect& b) {
+    return a.x <= b.x + b.w and b.x <= a.x + a.w and a.y <= b.y + b.h and b.y <= a.y + a.h;
+}
+
+inline SDL_Rect united(const SDL_Rect& a, const SDL_Rect& b) {
+    int x0 = std::min(a.x, b.x);
+    int y0 = std::min(a.y, b.y);
+    int x1 = std::max(a.x + a.w, b.x + b.w);
+    int y1 = std::max(a.y + a.h, b.y + b.h);
+    return {x0, y0, x1 - x0, y1 - y0};
+}
+
+}  // namespace
+
+// ========================================================================== //
+// Public interface                                                           //
+// ========================================================================== //
+
+// Constructors ============================================================= //
+DirtyRegion::DirtyRegion() : m_width(0), m_height(0) {
+    m_rects.reserve(MAX_RECTS + 1);
+}
+
+// Instance methods ========================================================= //
+
+void DirtyRegion::set_bounds(int width, int height) {
+    m_width = width;
+    m_height = height;
+    m_rects.clear();
+}
+
+/**
+ * Add the rectangle with corners (x0, y0) and (x1, y1), in any order
+ */
+void DirtyRegion::add(int x0, int y0, int x1, int y1) {
+    if (x0 > x1) std::swap(x0, x1);
+    if (y0 > y1) std::swap(y0, y1);
+
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, m_width - 1);
+    y1 = std::min(y1, m_height - 1);
+    if (x0 > x1 or y0 > y1) return;  // fully outside
+
+    merge({x0, y0, x1 - x0 + 1, y1 - y0 + 1});
+}
+
+void DirtyRegion::add(const DirtyRegion& other) {
+    for (const SDL_Rect& rect : other.m_rects) merge(rect);
+}
+
+size_t DirtyRegion::area() const {
+    size_t total = 0;
+    for (const SDL_Rect& rect : m_rects) total += static_cast<size_t>(rect.w) * rect.h;
+    return total;
+}
+
+// ========================================================================== //
+// Private interface                                                          //
+// ========================================================================== //
+
+// Instance methods ========================================================= //
+
+/**
+ * Grow the new rectangle with every rectangle it touches (the grown one can
+ * touch others, so the scan restarts) and store it.
+ */
+void DirtyRegion::merge(SDL_Rect rect) {
+    size_t i = 0;
+    while (i < m_rects.size()) {
+        if (touches(rect, m_rects[i])) {
+            rect = united(rect, m_rects[i]);
+            m_rects[i] = m_rects.back();
+            m_rects.pop_back();
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+    m_rects.push_back(rect);
+
+    // Too many small rectangles: present their bounding box instead
+    if (m_rects.size() > MAX_RECTS) {
+        SDL_Rect bounds = m_rects[0];
+        for (const SDL_Rect& r : m_rects) bounds = united(bounds, r);
+        m_rects.clear();
+        m_rects.push_back(bounds);
+    }
+}
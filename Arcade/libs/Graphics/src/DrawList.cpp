@@ -0,0 +1,390 @@
+/**
+ * @file DrawList.cpp
+ * @brief Per-frame list of recorded draw commands.
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "BitmapFont.h"
+#include "DrawList.h"
+#include "Sprite.h"
+
+namespace {
+
+// Pixels of a Bresenham line between two pixel positions
+inline uint64_t line_cost(int x0, int y0, int x1, int y1) {
+    return static_cast<uint64_t>(std::max(std::abs(x1 - x0), std::abs(y1 - y0))) + 1;
+}
+
+inline uint64_t line_cost(float x0, float y0, float x1, float y1) {
+    return line_cost(static_cast<int>(roundf(x0)), static_cast<int>(roundf(y0)),
+                     static_cast<int>(roundf(x1)), static_cast<int>(roundf(y1)));
+}
+
+inline bool is_integer(float value) { return value == std::floor(value); }
+
+// A zeroed command with an unbounded clip rectangle
+inline DrawCommand blank_command(DrawCommand::Type type) {
+    DrawCommand command = {};
+    command.type = type;
+    command.blend = BlendMode::SOURCE_OVER;
+    command.clip_x0 = command.clip_y0 = DrawCommand::NO_CLIP_MIN;
+    command.clip_x1 = command.clip_y1 = DrawCommand::NO_CLIP_MAX;
+    return command;
+}
+
+}  // namespace
+
+// ========================================================================== //
+// DrawCommand                                                                //
+// ========================================================================== //
+
+// Factory functions ======================================================== //
+
+DrawCommand DrawCommand::point(int x, int y, const Color& color) {
+    DrawCommand command = blank_command(POINT);
+    command.color = color.get_pixel_color();
+    command.v[0] = static_cast<float>(x);
+    command.v[1] = static_cast<float>(y);
+    command.x0 = command.x1 = x;
+    command.y0 = command.y1 = y;
+    return command;
+}
+
+DrawCommand DrawCommand::line(const Vec2D& p0, const Vec2D& p1, const Color& color) {
+    DrawCommand command = blank_command(LINE);
+    command.color = color.get_pixel_color();
+    command.v[0] = p0.get_x();
+    command.v[1] = p0.get_y();
+    command.v[2] = p1.get_x();
+    command.v[3] = p1.get_y();
+
+    // Bresenham works on the rounded end points
+    int x0 = roundf(p0.get_x()), y0 = roundf(p0.get_y());
+    int x1 = roundf(p1.get_x()), y1 = roundf(p1.get_y());
+    command.x0 = std::min(x0, x1);
+    command.y0 = std::min(y0, y1);
+    command.x1 = std::max(x0, x1);
+    command.y1 = std::max(y0, y1);
+    return command;
+}
+
+DrawCommand DrawCommand::triangle(const Vec2D& p0, const Vec2D& p1, const Vec2D& p2,
+                                  const Color& color, bool fill, const Color& fill_color) {
+    DrawCommand command = blank_command(TRIANGLE);
+    command.fill = fill;
+    command.color = color.get_pixel_color();
+    command.fill_color = fill_color.get_pixel_color();
+    command.v[0] = p0.get_x();
+    command.v[1] = p0.get_y();
+    command.v[2] = p1.get_x();
+    command.v[3] = p1.get_y();
+    command.v[4] = p2.get_x();
+    command.v[5] = p2.get_y();
+
+    command.x0 = std::floor(std::min({p0.get_x(), p1.get_x(), p2.get_x()}));
+    command.y0 = std::floor(std::min({p0.get_y(), p1.get_y(), p2.get_y()}));
+    command.x1 = std::ceil(std::max({p0.get_x(), p1.get_x(), p2.get_x()}));
+    command.y1 = std::ceil(std::max({p0.get_y(), p1.get_y(), p2.get_y()}));
+    return command;
+}
+
+DrawCommand DrawCommand::rectangle(const Vec2D& top_left, const Vec2D& bottom_right,
+                                   const Color& color, bool fill, const Color& fill_color) {
+    DrawCommand command = blank_command(RECTANGLE);
+    command.fill = fill;
+    command.color = color.get_pixel_color();
+    command.fill_color = fill_color.get_pixel_color();
+    command.v[0] = top_left.get_x();
+    command.v[1] = top_left.get_y();
+    command.v[2] = bottom_right.get_x();
+    command.v[3] = bottom_right.get_y();
+
+    command.x0 = std::floor(std::min(top_left.get_x(), bottom_right.get_x()));
+    command.y0 = std::floor(std::min(top_left.get_y(), bottom_right.get_y()));
+    command.x1 = std::ceil(std::max(top_left.get_x(), bottom_right.get_x()));
+    command.y1 = std::ceil(std::max(top_left.get_y(), bottom_right.get_y()));
+    return command;
+}
+
+DrawCommand DrawCommand::circle(const Vec2D& center, float radius,
+                                const Color& color, bool fill, const Color& fill_color) {
+    DrawCommand command = blank_command(CIRCLE);
+    command.fill = fill;
+    command.color = color.get_pixel_color();
+    command.fill_color = fill_color.get_pixel_color();
+    command.v[0] = center.get_x();
+    command.v[1] = center.get_y();
+    command.v[2] = radius;
+
+    // The midpoint algorithm works on the rounded center and radius
+    int cx = roundf(center.get_x());
+    int cy = roundf(center.get_y());
+    int r = roundf(radius);
+    command.x0 = cx - r;
+    command.y0 = cy - r;
+    command.x1 = cx + r;
+    command.y1 = cy + r;
+    return command;
+}
+
+DrawCommand DrawCommand::sprite(const Sprite& sprite, int x, int y) {
+    DrawCommand command = blank_command(SPRITE);
+    command.sprite_ptr = &sprite;
+    command.v[0] = static_cast<float>(x);
+    command.v[1] = static_cast<float>(y);
+    command.x0 = x;
+    command.y0 = y;
+    command.x1 = x + sprite.width() - 1;
+    command.y1 = y + sprite.height() - 1;
+    return command;
+}
+
+DrawCommand DrawCommand::text(const TextRun& run, int x, int y, const Color& color) {
+    DrawCommand command = blank_command(TEXT);
+    command.text_ptr = &run;
+    command.color = color.get_pixel_color();
+    command.v[0] = static_cast<float>(x);
+    command.v[1] = static_cast<float>(y);
+    command.x0 = x;
+    command.y0 = y;
+    command.x1 = x + run.width - 1;
+    command.y1 = y + run.height - 1;
+    return command;
+}
+
+// Instance methods ========================================================= //
+
+void DrawCommand::set_clip(const SDL_Rect& rect) {
+    clip_x0 = static_cast<int16_t>(std::clamp<int>(rect.x, NO_CLIP_MIN, NO_CLIP_MAX));
+    clip_y0 = static_cast<int16_t>(std::clamp<int>(rect.y, NO_CLIP_MIN, NO_CLIP_MAX));
+    clip_x1 = static_cast<int16_t>(std::clamp<int>(rect.x + rect.w - 1, NO_CLIP_MIN, NO_CLIP_MAX));
+    clip_y1 = static_cast<int16_t>(std::clamp<int>(rect.y + rect.h - 1, NO_CLIP_MIN, NO_CLIP_MAX));
+}
+
+/**
+ * Antialiased outlines blend a second pixel next to the aliased one, up to one
+ * pixel outside the bounding box. Points, sprites and texts have no outline.
+ */
+void DrawCommand::set_antialiased() {
+    if (type == POINT or type == SPRITE or type == TEXT or antialiased) return;
+
+    antialiased = true;
+    x0 -= 1;
+    y0 -= 1;
+    x1 += 1;
+    y1 += 1;
+}
+
+uint64_t DrawCommand::cost() const {
+    uint64_t w = static_cast<uint64_t>(x1 - x0) + 1;
+    uint64_t h = static_cast<uint64_t>(y1 - y0) + 1;
+
+    switch (type) {
+        case POINT:
+            return 1;
+        case LINE:
+            return line_cost(x0, y0, x1, y1);
+        case TRIANGLE:
+            return line_cost(v[0], v[1], v[2], v[3]) + line_cost(v[2], v[3], v[4], v[5]) +
+                   line_cost(v[4], v[5], v[0], v[1]) + (fill ? w * h / 2 : 0);
+        case RECTANGLE:
+            return 2 * (w + h) + (fill ? w * h : 0);
+        case CIRCLE: {
+            if (y1 < y0) return 0;  // negative radius: nothing is drawn
+            double r = (w - 1) / 2.0;
+            return static_cast<uint64_t>(6.0 * r + 1.0 + (fill ? M_PI * r * r : 0.0));
+        }
+        case SPRITE:
+            return sprite_ptr->visible_pixels();
+        case TEXT:
+            return text_ptr->pixels;
+    }
+    return 0;
+}
+
+/**
+ * Only an opaque filled rectangle with integer corners writes every pixel of
+ * its bounding box (outline on the border, fill spans inside). The bounding
+ * box of an antialiased one has a border of untouched pixels. An OPAQUE
+ * sprite copies every pixel of its bounding box too.
+ */
+bool DrawCommand::is_opaque_cover() const {
+    // Only OPAQUE and SOURCE_OVER at full alpha ignore the destination
+    if (blend != BlendMode::OPAQUE and blend != BlendMode::SOURCE_OVER) return false;
+    if (type == SPRITE) return sprite_ptr->mode() == Sprite::BlitMode::OPAQUE;
+
+    bool solid = blend == BlendMode::OPAQUE or
+                 (Color(color).get_alpha() == 255 and Color(fill_color).get_alpha() == 255);
+    return type == RECTANGLE and fill and !antialiased and solid and
+           is_integer(v[0]) and is_integer(v[1]) and is_integer(v[2]) and is_integer(v[3]);
+}
+
+// ========================================================================== //
+// DrawList                                                                   //
+// ========================================================================== //
+
+// Constructors ============================================================= //
+DrawList::DrawList() : m_width(0), m_height(0), m_bins_x(0), m_bins_y(0), m_cost_budget(0), m_stats() {}
+
+// Instance methods ========================================================= //
+
+void DrawList::set_bounds(int width, int height) {
+    m_width = width;
+    m_height = height;
+    m_bins_x = (width + BIN_SIZE - 1) / BIN_SIZE;
+    m_bins_y = (height + BIN_SIZE - 1) / BIN_SIZE;
+    m_cover.assign(static_cast<size_t>(m_bins_x) * m_bins_y, 0);
+    m_commands.clear();
+}
+
+/**
+ * Select the commands to replay: the visible commands are charged to the cost
+ * budget in submission order and, once one does not fit, the rest of the
+ * frame is dropped (drawing order is kept, so later commands never show up
+ * over missing ones). Only then the opaque rectangles kept are binned and the
+ * kept commands checked against the bins they touch: a dropped cover never
+ * hides anything. A command culled there was still charged to the budget.
+ */
+const std::vector<uint32_t>& DrawList::prepare() {
+    m_replay.clear();
+    m_stats = {m_commands.size(), 0, 0, 0};
+    std::fill(m_cover.begin(), m_cover.end(), 0);
+
+    auto clipped_cost = [this](const DrawCommand& command, uint64_t& cost) {
+        int x0, y0, x1, y1;
+        if (!clip(command, x0, y0, x1, y1)) return false;
+        cost = std::min(command.cost(), static_cast<uint64_t>(x1 - x0 + 1) * (y1 - y0 + 1));
+        return true;
+    };
+
+    bool over_budget = false;
+    uint64_t charged = 0;
+    for (uint32_t i = 0; i < m_commands.size(); i++) {
+        uint64_t cost = 0;
+        if (!clipped_cost(m_commands[i], cost)) {
+            m_stats.culled++;
+            continue;
+        }
+        if (over_budget or (m_cost_budget and charged + cost > m_cost_budget)) {
+            over_budget = true;
+            m_stats.dropped++;
+            continue;
+        }
+
+        charged += cost;
+        m_replay.push_back(i);
+    }
+
+    for (uint32_t index : m_replay) {
+        if (m_commands[index].is_opaque_cover()) mark_cover(m_commands[index], index + 1);
+    }
+
+    size_t kept = 0;
+    for (uint32_t index : m_replay) {
+        uint64_t cost = 0;
+        if (is_covered(m_commands[index], index + 1)) {
+            m_stats.culled++;
+            continue;
+        }
+
+        clipped_cost(m_commands[index], cost);
+        m_stats.cost += cost;
+        m_replay[kept++] = index;
+    }
+    m_replay.resize(kept);
+
+    return m_replay;
+}
+
+/**
+ * Two passes over the replayed commands: count the commands of every bin,
+ * then store their indices. A command is left out of the bins hidden by a
+ * later replayed opaque rectangle even when it is visible elsewhere.
+ */
+void DrawList::build_bins() {
+    m_bin_offsets.assign(m_cover.size() + 1, 0);
+
+    auto for_each_bin = [this](uint32_t index, auto&& action) {
+        int x0, y0, x1, y1;
+        clip(m_commands[index], x0, y0, x1, y1);  // never empty after prepare()
+
+        for (int by = y0 / BIN_SIZE; by <= y1 / BIN_SIZE; by++) {
+            for (int bx = x0 / BIN_SIZE; bx <= x1 / BIN_SIZE; bx++) {
+                size_t bin = by * m_bins_x + bx;
+                if (m_cover[bin] <= index + 1) action(bin);
+            }
+        }
+    };
+
+    for (uint32_t index : m_replay) {
+        for_each_bin(index, [this](size_t bin) { m_bin_offsets[bin + 1]++; });
+    }
+    for (size_t bin = 0; bin < m_cover.size(); bin++) m_bin_offsets[bin + 1] += m_bin_offsets[bin];
+
+    // The offsets are used as write cursors, then shifted back by one bin
+    m_bin_indices.resize(m_bin_offsets.back());
+    for (uint32_t index : m_replay) {
+        for_each_bin(index, [this, index](size_t bin) { m_bin_indices[m_bin_offsets[bin]++] = index; });
+    }
+    for (size_t bin = m_cover.size(); bin > 0; bin--) m_bin_offsets[bin] = m_bin_offsets[bin - 1];
+    m_bin_offsets[0] = 0;
+}
+
+SDL_Rect DrawList::bin_rect(size_t bin) const {
+    int x = static_cast<int>(bin % m_bins_x) * BIN_SIZE;
+    int y = static_cast<int>(bin / m_bins_x) * BIN_SIZE;
+    return {x, y, std::min(BIN_SIZE, m_width - x), std::min(BIN_SIZE, m_height - y)};
+}
+
+// ========================================================================== //
+// Private interface                                                          //
+// ========================================================================== //
+
+// Instance methods ========================================================= //
+
+// Bounding box of the command clipped to its clip rectangle and to the screen,
+// false when empty
+bool DrawList::clip(const DrawCommand& command, int& x0, int& y0, int& x1, int& y1) const {
+    x0 = std::max({command.x0, static_cast<int>(command.clip_x0), 0});
+    y0 = std::max({command.y0, static_cast<int>(command.clip_y0), 0});
+    x1 = std::min({command.x1, static_cast<int>(command.clip_x1), m_width - 1});
+    y1 = std::min({command.y1, static_cast<int>(command.clip_y1), m_height - 1});
+    return x0 <= x1 and y0 <= y1;
+}
+
+void DrawList::mark_cover(const DrawCommand& command, uint32_t index) {
+    int x0, y0, x1, y1;
+    if (!clip(command, x0, y0, x1, y1)) return;
+
+    for (int by = y0 / BIN_SIZE; by <= y1 / BIN_SIZE; by++) {
+        // The bins on the right and bottom borders can be smaller than BIN_SIZE
+        int bin_y0 = by * BIN_SIZE;
+        int bin_y1 = std::min(bin_y0 + BIN_SIZE, m_height) - 1;
+        if (bin_y0 < y0 or bin_y1 > y1) continue;
+
+        for (int bx = x0 / BIN_SIZE; bx <= x1 / BIN_SIZE; bx++) {
+            int bin_x0 = bx * BIN_SIZE;
+            int bin_x1 = std::min(bin_x0 + BIN_SIZE, m_width) - 1;
+            if (bin_x0 < x0 or bin_x1 > x1) continue;
+
+            m_cover[by * m_bins_x + bx] = index;
+        }
+    }
+}
+
+// True when every bin touched by the command is covered by a later command
+bool DrawList::is_covered(const DrawCommand& command, uint32_t index) const {
+    int x0, y0, x1, y1;
+    if (!clip(command, x0, y0, x1, y1)) return false;
+
+    for (int by = y0 / BIN_SIZE; by <= y1 / BIN_SIZE; by++) {
+        for (int bx = x0 / BIN_SIZE; bx <= x1 / BIN_SIZE; bx++) {
+            if (m_cover[by * m_bins_x + bx] <= index) return false;
+        }
+    }
+    return true;
+}
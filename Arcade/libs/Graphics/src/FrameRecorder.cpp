@@ -0,0 +1,225 @@
+/**
+ * @file FrameRecorder.cpp
+ * @brief Streams presented frames to disk on a background writer thread.
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include "FrameRecorder.h"
+#include "pixel_scale.h"
+
+namespace {
+
+// BT.601 limited range in 8-bit fixed point
+inline uint8_t luma(int r, int g, int b) {return ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;}
+inline uint8_t chroma_u(int r, int g, int b) {return ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;}
+inline uint8_t chroma_v(int r, int g, int b) {return ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;}
+
+}  // namespace
+
+// ========================================================================== //
+// Public interface                                                           //
+// ========================================================================== //
+
+// Constructors ============================================================= //
+FrameRecorder::FrameRecorder() : m_width(0), m_height(0), m_format(Format::Y4M), m_stream_offset(0),
+                                 m_sequence(0), m_captured(0), m_consumed(0), m_written(0), m_dropped(0),
+                                 m_signals(0), m_running(false), m_failed(false) {}
+
+// Instance methods ========================================================= //
+
+/**
+ * Open the stream and its index, write their headers and preallocate the
+ * ring: nothing is allocated once recording. The fps only goes in the Y4M
+ * header.
+ */
+bool FrameRecorder::start(const std::string& path, int width, int height, Format format,
+                          unsigned fps, size_t ring_frames) {
+    if (is_recording()) throw std::runtime_error("Frame recorder already started!");
+    if (width <= 0 or height <= 0 or ring_frames == 0) throw std::runtime_error("Invalid capture size!");
+
+    m_stream.open(path, std::ios::binary | std::ios::trunc);
+    m_index.open(path + ".idx", std::ios::trunc);
+    if (!m_stream.is_open() or !m_index.is_open()) {
+        std::cerr << "Error: Failed to open the capture " << path << std::endl;
+        m_stream.close();
+        m_index.close();
+        m_stream.clear();
+        m_index.clear();
+        return false;
+    }
+
+    m_width = width;
+    m_height = height;
+    m_format = format;
+    size_t area = static_cast<size_t>(width) * height;
+    m_ring.resize(ring_frames);
+    for (Slot& slot : m_ring) slot.pixels.resize(area * sizeof(uint32_t));
+    m_argb.resize(area);
+    m_planes.resize(format == Format::Y4M ? area * 3 : 0);
+
+    if (format == Format::Y4M) {
+        m_stream << "YUV4MPEG2 W" << width << " H" << height << " F" << fps << ":1 Ip A1:1 C444\n";
+    }
+    m_index << "# " << (format == Format::Y4M ? "y4m" : "argb8888") << " " << width << "x" << height << "\n"
+            << "# sequence offset time_us\n";
+    m_stream_offset = static_cast<uint64_t>(m_stream.tellp());
+
+    m_sequence = 0;
+    m_captured = 0;
+    m_consumed = 0;
+    m_written = 0;
+    m_dropped = 0;
+    m_failed = false;
+    m_running = true;
+    m_start = std::chrono::steady_clock::now();
+    m_writer = std::thread(&FrameRecorder::write_loop, this);
+    return true;
+}
+
+void FrameRecorder::stop() {
+    if (!is_recording()) return;
+
+    m_running = false;
+    m_signals.fetch_add(1);
+    m_signals.notify_one();
+    m_writer.join();
+
+    m_stream.close();
+    m_index.close();
+    m_stream.clear();
+    m_index.clear();
+}
+
+/**
+ * Copy the frame into the next free slot and wake the writer. The rows are
+ * copied with a single memcpy when the surface has no row padding (always
+ * for ARGB). A full ring drops the frame: the game thread never waits.
+ */
+bool FrameRecorder::push(const ScreenBuffer& frame) {
+    if (!is_recording()) throw std::runtime_error("Frame recorder not started!");
+    if (frame.width() != m_width or frame.height() != m_height) {
+        throw std::runtime_error("Frame size does not match the capture!");
+    }
+
+    uint64_t sequence = m_sequence++;
+    uint64_t captured = m_captured.load(std::memory_order_relaxed);
+    if (captured - m_consumed.load(std::memory_order_acquire) == m_ring.size()) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Slot& slot = m_ring[captured % m_ring.size()];
+    slot.indexed = frame.is_indexed();
+    size_t row_bytes = m_width * (slot.indexed ? sizeof(uint8_t) : sizeof(uint32_t));
+    const uint8_t* pixels = reinterpret_cast<const uint8_t*>(frame.get_row(0));
+    if (static_cast<size_t>(frame.pitch()) == row_bytes) {
+        std::memcpy(slot.pixels.data(), pixels, row_bytes * m_height);
+    } else {
+        for (int y = 0; y < m_height; y++) {
+            std::memcpy(slot.pixels.data() + y * row_bytes, pixels + y * frame.pitch(), row_bytes);
+        }
+    }
+    if (slot.indexed) std::memcpy(slot.palette, frame.palette()->colors(), sizeof(slot.palette));
+    slot.sequence = sequence;
+    slot.time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - m_start).count();
+
+    m_captured.store(captured + 1, std::memory_order_release);
+    m_signals.fetch_add(1, std::memory_order_release);
+    m_signals.notify_one();
+    return true;
+}
+
+FrameRecorder::Stats FrameRecorder::stats() const {
+    return {m_captured.load(), m_dropped.load(), m_written.load()};
+}
+
+// Destructor =============================================================== //
+FrameRecorder::~FrameRecorder() {
+    stop();
+}
+
+// ========================================================================== //
+// Private interface                                                          //
+// ========================================================================== //
+
+// Instance methods ========================================================= //
+
+// Write the slots in order until stopped and the ring is empty
+void FrameRecorder::write_loop() {
+    uint32_t signals = m_signals.load(std::memory_order_acquire);
+
+    while (true) {
+        bool running = m_running.load();
+        uint64_t consumed = m_consumed.load(std::memory_order_relaxed);
+
+        if (consumed != m_captured.load(std::memory_order_acquire)) {
+            write_slot(m_ring[consumed % m_ring.size()]);
+            m_consumed.store(consumed + 1, std::memory_order_release);
+        } else if (running) {
+            m_signals.wait(signals, std::memory_order_acquire);
+            signals = m_signals.load(std::memory_order_acquire);
+        } else {
+            break;  // stopped, and the last frame has been written
+        }
+    }
+}
+
+/**
+ * Expand an indexed frame through its palette, convert it for the stream and
+ * append it, then its line to the index. After a failed write the next
+ * frames are only freed.
+ */
+void FrameRecorder::write_slot(const Slot& slot) {
+    if (m_failed) return;
+
+    size_t area = static_cast<size_t>(m_width) * m_height;
+    const uint32_t* argb = reinterpret_cast<const uint32_t*>(slot.pixels.data());
+    if (slot.indexed) {
+        expand_indexed(slot.pixels.data(), slot.palette, m_argb.data(), static_cast<int>(area));
+        argb = m_argb.data();
+    }
+
+    const char* data = reinterpret_cast<const char*>(argb);
+    size_t size = area * sizeof(uint32_t);
+    if (m_format == Format::Y4M) {
+        static constexpr char FRAME_HEADER[] = "FRAME\n";
+        m_stream.write(FRAME_HEADER, sizeof(FRAME_HEADER) - 1);
+        m_stream_offset += sizeof(FRAME_HEADER) - 1;
+        to_yuv(argb);
+        data = reinterpret_cast<const char*>(m_planes.data());
+        size = m_planes.size();
+    }
+
+    m_stream.write(data, size);
+    m_index << slot.sequence << ' ' << m_stream_offset << ' ' << slot.time_us << '\n';
+    m_stream_offset += size;
+
+    if (!m_stream or !m_index) {
+        std::cerr << "Error: Failed to write the capture, the next frames are dropped" << std::endl;
+        m_failed = true;
+        return;
+    }
+    m_written.fetch_add(1, std::memory_order_relaxed);
+}
+
+// The Y, U and V planes (4:4:4) of the frame, one after the other
+void FrameRecorder::to_yuv(const uint32_t* argb) {
+    size_t area = static_cast<size_t>(m_width) * m_height;
+    uint8_t* y_plane = m_planes.data();
+    uint8_t* u_plane = y_plane + area;
+    uint8_t* v_plane = u_plane + area;
+
+    for (size_t i = 0; i < area; i++) {
+        int r = (argb[i] >> Color::RED_SHIFT) & 0xFF;
+        int g = (argb[i] >> Color::GREEN_SHIFT) & 0xFF;
+        int b = (argb[i] >> Color::BLUE_SHIFT) & 0xFF;
+        y_plane[i] = luma(r, g, b);
+        u_plane[i] = chroma_u(r, g, b);
+        v_plane[i] = chroma_v(r, g, b);
+    }
+}
@@ -0,0 +1,104 @@
+/**
+ * @file Palette.cpp
+ * @brief Up to 256 colors for the 8-bit indexed ScreenBuffer mode.
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#include <stdexcept>
+#include "Palette.h"
+
+namespace {
+
+constexpr uint32_t RGB_MASK = 0x00FFFFFF;
+
+inline int channel(uint32_t argb, int shift) { return static_cast<int>((argb >> shift) & 0xFF); }
+
+inline int distance(uint32_t a, uint32_t b) {
+    int dr = channel(a, Color::RED_SHIFT) - channel(b, Color::RED_SHIFT);
+    int dg = channel(a, Color::GREEN_SHIFT) - channel(b, Color::GREEN_SHIFT);
+    int db = channel(a, Color::BLUE_SHIFT) - channel(b, Color::BLUE_SHIFT);
+    return dr * dr + dg * dg + db * db;
+}
+
+// Index in the 16x16x16 cube: the high 4 bits of every channel
+inline uint32_t cube_index(uint32_t argb) {
+    return ((argb >> 12) & 0xF00) | ((argb >> 8) & 0x0F0) | ((argb >> 4) & 0x00F);
+}
+
+}  // namespace
+
+// ========================================================================== //
+// Public interface                                                           //
+// ========================================================================== //
+
+// Constructors ============================================================= //
+
+Palette::Palette() : Palette({Color::Black(), Color::Gray(), Color::White(), Color::Red(), Color::Green(),
+                              Color::Blue(), Color::Cyan(), Color::Magenta(), Color::Yellow(), Color::Orange(),
+                              Color::Purple()}) {}
+
+Palette::Palette(const std::vector<Color>& colors) : m_colors(MAX_COLORS, Color::BLACK),
+                                                     m_size(static_cast<int>(colors.size())) {
+    if (colors.empty() or colors.size() > MAX_COLORS) throw std::invalid_argument("A palette has 1 to 256 colors!");
+
+    for (int i = 0; i < m_size; i++) m_colors[i] = colors[i].get_pixel_color() | 0xFF000000;
+    build();
+}
+
+// Instance methods ========================================================= //
+
+uint8_t Palette::index_of(uint32_t argb) const {
+    auto exact = m_exact.find(argb & RGB_MASK);
+    return exact != m_exact.end() ? exact->second : m_cube[cube_index(argb)];
+}
+
+// ========================================================================== //
+// Private interface                                                          //
+// ========================================================================== //
+
+// Instance methods ========================================================= //
+
+void Palette::build() {
+    // First index wins for duplicated colors
+    for (int i = m_size - 1; i >= 0; i--) m_exact[m_colors[i] & RGB_MASK] = static_cast<uint8_t>(i);
+
+    // Nearest entry of the center of every cube cell
+    m_cube.resize(16 * 16 * 16);
+    for (uint32_t cell = 0; cell < m_cube.size(); cell++) {
+        uint32_t r = ((cell >> 8) & 0xF) * 16 + 8, g = ((cell >> 4) & 0xF) * 16 + 8, b = (cell & 0xF) * 16 + 8;
+        m_cube[cell] = nearest((r << Color::RED_SHIFT) | (g << Color::GREEN_SHIFT) | (b << Color::BLUE_SHIFT));
+    }
+
+    // Blend table: unused destination entries map to themselves
+    m_blend.resize(static_cast<size_t>(m_size) * (ALPHA_LEVELS - 1) * MAX_COLORS);
+    for (int source = 0; source < m_size; source++) {
+        for (uint32_t level = 1; level < ALPHA_LEVELS; level++) {
+            uint8_t* table = m_blend.data() + (static_cast<size_t>(source) * (ALPHA_LEVELS - 1) + (level - 1)) * MAX_COLORS;
+            uint32_t alpha = level * 255 / ALPHA_LEVELS;
+            Color translucent((m_colors[source] & RGB_MASK) | (alpha << Color::ALPHA_SHIFT));
+
+            for (int destination = 0; destination < MAX_COLORS; destination++) {
+                if (destination >= m_size) {
+                    table[destination] = static_cast<uint8_t>(destination);
+                    continue;
+                }
+                Color blended = Color::alpha_blending(translucent, Color(m_colors[destination]));
+                table[destination] = nearest(blended.get_pixel_color());
+            }
+        }
+    }
+}
+
+uint8_t Palette::nearest(uint32_t argb) const {
+    int best = 0;
+    int best_distance = distance(argb, m_colors[0]);
+    for (int i = 1; i < m_size and best_distance > 0; i++) {
+        int d = distance(argb, m_colors[i]);
+        if (d < best_distance) {
+            best = i;
+            best_distance = d;
+        }
+    }
+    return static_cast<uint8_t>(best);
+}
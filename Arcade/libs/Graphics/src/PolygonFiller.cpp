@@ -0,0 +1,138 @@
+/**
+ * @file PolygonFiller.cpp
+ * @brief Scan converter that turns a polygon into horizontal spans.
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "PolygonFiller.h"
+
+namespace {
+
+constexpr int FRACTION_BITS = 32;
+constexpr int64_t ONE = int64_t(1) << FRACTION_BITS;
+// Rounding slack: absorbs the error accumulated by stepping the slope so an
+// exact integer crossing is never pushed to the neighbouring pixel
+constexpr int64_t SNAP = ONE >> 16;
+
+inline int64_t to_fixed(double value) { return std::llround(value * static_cast<double>(ONE)); }
+inline int fixed_ceil(int64_t value) { return static_cast<int>((value - SNAP + ONE - 1) >> FRACTION_BITS); }
+inline int fixed_floor(int64_t value) { return static_cast<int>((value + SNAP) >> FRACTION_BITS); }
+
+}  // namespace
+
+// ========================================================================== //
+// Public interface                                                           //
+// ========================================================================== //
+
+// Instance methods ========================================================= //
+
+/**
+ * Scan-convert the polygon and return its spans, top to bottom and left to
+ * right on every row. Only the rows in [clip_top, clip_bottom] are produced.
+ *
+ * A row y is crossed by an edge when y_top <= y < y_bottom (so shared vertices
+ * are counted once and horizontal edges are ignored). Each pair of crossings
+ * gives a span from ceil(x_left) to floor(x_right), kept one pixel inside the
+ * bounding box so the outline drawn on top is not covered.
+ *
+ * The returned reference stays valid until the next call.
+ */
+const std::vector<PolygonFiller::Span>& PolygonFiller::scan(const std::vector<Vec2D>& points, int clip_top, int clip_bottom) {
+    m_spans.clear();
+    m_edge_table.clear();
+    m_active_edges.clear();
+
+    if (points.empty()) return m_spans;
+
+    // Find the horizontal extent of the polygon (to keep the fill off the border)
+    float left = points[0].get_x();
+    float right = points[0].get_x();
+    for (const Vec2D& p : points) {
+        left = std::min(left, p.get_x());
+        right = std::max(right, p.get_x());
+    }
+    const int left_limit = static_cast<int>(left) + 1;
+    const int right_limit = static_cast<int>(right) - 1;
+
+    // Build the edge table: one entry for every non horizontal edge, already
+    // positioned on the first visible scanline it crosses
+    size_t j = points.size() - 1;
+    for (size_t i = 0; i < points.size(); i++) {
+        const Vec2D* top = &points[i];
+        const Vec2D* bottom = &points[j];
+        j = i;
+
+        if (is_equal(top->get_y(), bottom->get_y())) continue;  // ignore perfectly horizontal edges
+        if (top->get_y() > bottom->get_y()) std::swap(top, bottom);
+
+        int y_start = static_cast<int>(std::ceil(top->get_y()));
+        int y_end = static_cast<int>(std::ceil(bottom->get_y())) - 1;
+        y_start = std::max(y_start, clip_top);
+        y_end = std::min(y_end, clip_bottom);
+        if (y_start > y_end) continue;
+
+        double slope = (static_cast<double>(bottom->get_x()) - top->get_x()) /
+                       (static_cast<double>(bottom->get_y()) - top->get_y());
+        double x_start = top->get_x() + (y_start - static_cast<double>(top->get_y())) * slope;
+
+        m_edge_table.push_back({y_start, y_end, to_fixed(x_start), to_fixed(slope)});
+    }
+
+    if (m_edge_table.empty()) return m_spans;
+
+    std::sort(m_edge_table.begin(), m_edge_table.end(),
+              [](const Edge& a, const Edge& b) { return a.y_start < b.y_start; });
+
+    // Walk the scanlines keeping only the edges that cross the current one
+    size_t next_edge = 0;
+    int y = m_edge_table.front().y_start;
+
+    while (next_edge < m_edge_table.size() or !m_active_edges.empty()) {
+        // Activate the edges that start on this row
+        while (next_edge < m_edge_table.size() and m_edge_table[next_edge].y_start == y) {
+            m_active_edges.push_back(m_edge_table[next_edge++]);
+        }
+
+        // Sort by x: insertion sort, the order barely changes from row to row
+        for (size_t k = 1; k < m_active_edges.size(); k++) {
+            Edge edge = m_active_edges[k];
+            size_t l = k;
+            for (; l > 0 and m_active_edges[l - 1].x > edge.x; l--) m_active_edges[l] = m_active_edges[l - 1];
+            m_active_edges[l] = edge;
+        }
+
+        // Emit a span for every pair of crossings
+        if (m_active_edges.size() % 2 == 0) {  // ensure valid pairs
+            int previous_end = left_limit - 1;
+            for (size_t k = 0; k < m_active_edges.size(); k += 2) {
+                // spans meeting on an exact crossing must not cover (and blend) it twice
+                int start_x = std::max(fixed_ceil(m_active_edges[k].x), previous_end + 1);
+                int end_x = std::min(fixed_floor(m_active_edges[k + 1].x), right_limit);
+
+                if (start_x <= end_x) {
+                    m_spans.push_back({y, start_x, end_x});
+                    previous_end = end_x;
+                }
+            }
+        }
+
+        // Drop the edges ending on this row and step the others
+        size_t kept = 0;
+        for (Edge& edge : m_active_edges) {
+            if (edge.y_end > y) {
+                edge.x += edge.dx;
+                m_active_edges[kept++] = edge;
+            }
+        }
+        m_active_edges.resize(kept);
+
+        y++;
+        // Jump over rows without any edge (e.g. a clipped gap)
+        if (m_active_edges.empty() and next_edge < m_edge_table.size()) y = m_edge_table[next_edge].y_start;
+    }
+
+    return m_spans;
+}
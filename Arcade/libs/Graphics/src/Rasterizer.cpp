@@ -0,0 +1,532 @@
+/**
+ * @file Rasterizer.cpp
+ * @brief Draws recorded commands into a ScreenBuffer inside a clip rectangle.
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "Rasterizer.h"
+
+namespace {
+
+inline bool is_integer(float value) { return value == std::floor(value); }
+
+}  // namespace
+
+// ========================================================================== //
+// Public interface                                                           //
+// ========================================================================== //
+
+// Instance methods ========================================================= //
+
+/**
+ * Draw the command, writing only the pixels inside the clip rectangle, the
+ * clip rectangle of the command and the buffer. Commands whose bounding box
+ * is outside are rejected right away. The pool is used for large triangle
+ * fills, leave it null when the caller is already running on the pool.
+ */
+void Rasterizer::draw(ScreenBuffer& buffer, const DrawCommand& command, const SDL_Rect& clip, ThreadPool* pool) {
+    m_buffer = &buffer;
+    m_clip_x0 = std::max({clip.x, static_cast<int>(command.clip_x0), 0});
+    m_clip_y0 = std::max({clip.y, static_cast<int>(command.clip_y0), 0});
+    m_clip_x1 = std::min({clip.x + clip.w - 1, static_cast<int>(command.clip_x1), buffer.width() - 1});
+    m_clip_y1 = std::min({clip.y + clip.h - 1, static_cast<int>(command.clip_y1), buffer.height() - 1});
+    if (m_clip_x0 > m_clip_x1 or m_clip_y0 > m_clip_y1) return;
+
+    // Trivial reject
+    if (command.x1 < m_clip_x0 or command.x0 > m_clip_x1 or command.y1 < m_clip_y0 or command.y0 > m_clip_y1) return;
+
+    // The only branch on the blend mode: everything below is instantiated per mode
+    switch (command.blend) {
+        case BlendMode::OPAQUE:
+            draw_command<BlendMode::OPAQUE>(command, pool);
+            break;
+        case BlendMode::SOURCE_OVER:
+            draw_command<BlendMode::SOURCE_OVER>(command, pool);
+            break;
+        case BlendMode::ADDITIVE:
+            draw_command<BlendMode::ADDITIVE>(command, pool);
+            break;
+        case BlendMode::MULTIPLY:
+            draw_command<BlendMode::MULTIPLY>(command, pool);
+            break;
+        case BlendMode::XOR:
+            draw_command<BlendMode::XOR>(command, pool);
+            break;
+    }
+}
+
+// ========================================================================== //
+// Private interface                                                          //
+// ========================================================================== //
+
+// Instance methods ========================================================= //
+
+template <BlendMode M>
+void Rasterizer::draw_command(const DrawCommand& command, ThreadPool* pool) {
+    const float* v = command.v;
+    Color color(command.color);
+    Color fill_color(command.fill_color);
+
+    auto line = [this, &command](float x0, float y0, float x1, float y1, const Color& color) {
+        if (command.antialiased) {
+            draw_line_aa<M>(x0, y0, x1, y1, color);
+        } else {
+            draw_line<M>(x0, y0, x1, y1, color);
+        }
+    };
+
+    switch (command.type) {
+        case DrawCommand::POINT:
+            plot<M>(command.x0, command.y0, color);
+            break;
+
+        case DrawCommand::LINE:
+            line(v[0], v[1], v[2], v[3], color);
+            break;
+
+        case DrawCommand::TRIANGLE: {
+            if (command.fill) {
+                SDL_Rect fill_clip = {m_clip_x0, m_clip_y0, m_clip_x1 - m_clip_x0 + 1, m_clip_y1 - m_clip_y0 + 1};
+                if (m_triangle_rasterizer.setup(Vec2D(v[0], v[1]), Vec2D(v[2], v[3]), Vec2D(v[4], v[5]), fill_clip)) {
+                    m_triangle_rasterizer.fill<M>(*m_buffer, fill_color, pool);
+                }
+            }
+
+            line(v[0], v[1], v[2], v[3], color);
+            line(v[2], v[3], v[4], v[5], color);
+            line(v[4], v[5], v[0], v[1], color);
+            break;
+        }
+
+        case DrawCommand::RECTANGLE: {
+            if (!command.antialiased and is_integer(v[0]) and is_integer(v[1]) and
+                is_integer(v[2]) and is_integer(v[3])) {
+                draw_rectangle<M>(command.x0, command.y0, command.x1, command.y1, color, command.fill, fill_color);
+                break;
+            }
+
+            // Corners in the same order as Rectangle2D::get_points()
+            if (command.fill) {
+                m_points.resize(4);
+                m_points[0] = Vec2D(v[0], v[1]);
+                m_points[1] = Vec2D(v[2], v[1]);
+                m_points[2] = Vec2D(v[2], v[3]);
+                m_points[3] = Vec2D(v[0], v[3]);
+                fill_poly<M>(m_points, fill_color);
+            }
+
+            line(v[0], v[1], v[2], v[1], color);
+            line(v[2], v[1], v[2], v[3], color);
+            line(v[2], v[3], v[0], v[3], color);
+            line(v[0], v[3], v[0], v[1], color);
+            break;
+        }
+
+        case DrawCommand::CIRCLE: {
+            // Integer center and radius, as in the bounding box
+            int cx = roundf(v[0]);
+            int cy = roundf(v[1]);
+            int radius = roundf(v[2]);
+
+            if (command.fill) fill_circle<M>(cx, cy, radius, fill_color);
+            if (command.antialiased) {
+                draw_circle_outline_aa<M>(cx, cy, radius, color);
+            } else {
+                draw_circle_outline<M>(cx, cy, radius, color);
+            }
+            break;
+        }
+
+        case DrawCommand::SPRITE:
+            draw_sprite<M>(*command.sprite_ptr, command.x0, command.y0);
+            break;
+
+        case DrawCommand::TEXT:
+            draw_text<M>(*command.text_ptr, command.x0, command.y0, color);
+            break;
+    }
+}
+
+template <BlendMode M>
+void Rasterizer::span(int x0, int x1, int y, const Color& color) {
+    if (y < m_clip_y0 or y > m_clip_y1) return;
+    x0 = std::max(x0, m_clip_x0);
+    x1 = std::min(x1, m_clip_x1);
+    if (x0 > x1) return;
+
+    m_buffer->write_span<M>(x0, x1, y, color.get_pixel_color());
+}
+
+/**
+ * Draw a line using Bresnham's Algorithm, clipped before the walk.
+ *
+ * With the doubled deltas a (major axis) and b (minor axis), the decision
+ * variable after k steps always lies in [b - a, b), so the number of minor
+ * steps taken by then is m(k) = floor((k * b + a / 2) / a). The clip
+ * rectangle bounds k on the major axis directly and, m(k) being monotonic, on
+ * the minor axis too (parametric clipping in the style of Liang-Barsky, but on
+ * the integer step index). The walk then starts at the first visible step
+ * with the exact state it would have had, so the pixels are the same as the
+ * unclipped line and the loop needs no bounds checks.
+ */
+template <BlendMode M>
+void Rasterizer::draw_line(float from_x, float from_y, float to_x, float to_y, const Color& color) {
+    int x0 = roundf(from_x);
+    int y0 = roundf(from_y);
+    int x1 = roundf(to_x);
+    int y1 = roundf(to_y);
+
+    // Work on a generic (major, minor) frame: u along the major axis
+    bool x_major = std::abs(x1 - x0) >= std::abs(y1 - y0);
+    int u0 = x_major ? x0 : y0, v0 = x_major ? y0 : x0;
+    int u1 = x_major ? x1 : y1, v1 = x_major ? y1 : x1;
+    int iu = (u1 > u0) - (u1 < u0);  // evaluate to 1 or -1 (depends of which direction the line is)
+    int iv = (v1 > v0) - (v1 < v0);
+    int64_t a = int64_t(std::abs(u1 - u0)) * 2;  // * 2 to get rid of any floating point math
+    int64_t b = int64_t(std::abs(v1 - v0)) * 2;
+    int64_t steps = a / 2;
+
+    int clip_u0 = x_major ? m_clip_x0 : m_clip_y0, clip_u1 = x_major ? m_clip_x1 : m_clip_y1;
+    int clip_v0 = x_major ? m_clip_y0 : m_clip_x0, clip_v1 = x_major ? m_clip_y1 : m_clip_x1;
+
+    // Step range allowed by a coordinate moving by `direction` per step
+    auto step_range = [](int start, int direction, int low, int high, int64_t& k_min, int64_t& k_max) {
+        if (direction > 0) {
+            k_min = int64_t(low) - start;
+            k_max = int64_t(high) - start;
+        } else if (direction < 0) {
+            k_min = int64_t(start) - high;
+            k_max = int64_t(start) - low;
+        } else if (start < low or start > high) {
+            k_min = 1;  // empty
+            k_max = 0;
+        } else {
+            k_min = INT64_MIN / 4;
+            k_max = INT64_MAX / 4;
+        }
+    };
+
+    // Major axis: the step index k
+    int64_t k_begin, k_end;
+    step_range(u0, iu, clip_u0, clip_u1, k_begin, k_end);
+    k_begin = std::max<int64_t>(k_begin, 0);
+    k_end = std::min<int64_t>(k_end, steps);
+
+    // Minor axis: the number of minor steps m(k), then back to k
+    int64_t m_low, m_high;
+    step_range(v0, iv, clip_v0, clip_v1, m_low, m_high);
+    m_low = std::max<int64_t>(m_low, 0);
+    m_high = std::min<int64_t>(m_high, b / 2);
+    if (m_low > m_high) return;
+    if (b > 0) {
+        auto floor_div = [](int64_t n, int64_t d) { return n >= 0 ? n / d : -((-n + d - 1) / d); };
+        if (m_low > 0) k_begin = std::max(k_begin, -floor_div(-(m_low * a - a / 2), b));  // ceil
+        k_end = std::min(k_end, -floor_div(-((m_high + 1) * a - a / 2), b) - 1);
+    }
+    if (k_begin > k_end) return;
+
+    // Jump to the first visible step
+    int64_t m = (k_begin * b + a / 2) / std::max<int64_t>(a, 1);
+    int64_t d = (b - a / 2) + k_begin * b - m * a;  // decision variable
+    int u = u0 + static_cast<int>(k_begin) * iu;
+    int v = v0 + static_cast<int>(m) * iv;
+
+    const uint32_t argb = color.get_pixel_color();
+    for (int64_t k = k_begin; ; k++) {
+        if (x_major) {
+            m_buffer->write_pixel<M>(argb, u, v);
+        } else {
+            m_buffer->write_pixel<M>(argb, v, u);
+        }
+        if (k == k_end) break;
+
+        if (d >= 0) {
+            d -= a;
+            v += iv;
+        }
+        d += b;
+        u += iu;
+    }
+}
+
+/**
+ * Antialiased line (Xiaolin Wu). The line is walked along its major axis in
+ * increasing order, one pixel column (or row) per step: the exact position on
+ * the minor axis, in 16.16 fixed point, falls between two pixels that get
+ * 1 - fraction and fraction of the color alpha. The position at step k is
+ * start + k * gradient, so the walk starts directly at the first step inside
+ * the clip rectangle and gives the same pixels as the unclipped line. End
+ * points are not weighted: the lines of an outline join without gaps.
+ */
+template <BlendMode M>
+void Rasterizer::draw_line_aa(float from_x, float from_y, float to_x, float to_y, const Color& color) {
+    const uint32_t argb = color.get_pixel_color();
+    bool x_major = std::fabs(to_x - from_x) >= std::fabs(to_y - from_y);
+
+    // (u, v) = (major, minor) axes, walked with increasing u
+    float u0 = x_major ? from_x : from_y, v0 = x_major ? from_y : from_x;
+    float u1 = x_major ? to_x : to_y, v1 = x_major ? to_y : to_x;
+    if (u0 > u1) {
+        std::swap(u0, u1);
+        std::swap(v0, v1);
+    }
+
+    int first = roundf(u0);
+    int last = roundf(u1);
+    float gradient = u1 > u0 ? (v1 - v0) / (u1 - u0) : 0.0f;
+    int64_t step = std::llround(static_cast<double>(gradient) * 65536.0);
+    int64_t start = std::llround((v0 + gradient * (first - u0)) * 65536.0);
+
+    int clip_u0 = x_major ? m_clip_x0 : m_clip_y0;
+    int clip_u1 = x_major ? m_clip_x1 : m_clip_y1;
+    int k_begin = std::max(0, clip_u0 - first);
+    int k_end = std::min(last, clip_u1) - first;
+
+    for (int k = k_begin; k <= k_end; k++) {
+        int64_t position = start + k * step;
+        int u = first + k;
+        int v = static_cast<int>(position >> 16);  // floor
+        uint32_t fraction = static_cast<uint32_t>(position & 0xFFFF) >> 8;
+
+        if (x_major) {  // two rows: one run each
+            run_push<M>(m_runs[0], u, v, with_coverage(argb, 255 - fraction));
+            if (fraction) run_push<M>(m_runs[1], u, v + 1, with_coverage(argb, fraction));
+        } else {        // two neighbours on the same row
+            run_push<M>(m_runs[0], v, u, with_coverage(argb, 255 - fraction));
+            if (fraction) run_push<M>(m_runs[0], v + 1, u, with_coverage(argb, fraction));
+        }
+    }
+
+    run_flush<M>(m_runs[0]);
+    run_flush<M>(m_runs[1]);
+}
+
+// Append the pixel to the run, flushing it first when (x, y) does not extend it
+template <BlendMode M>
+void Rasterizer::run_push(CoverageRun& run, int x, int y, uint32_t argb) {
+    if (y < m_clip_y0 or y > m_clip_y1) return;
+
+    if (!run.pixels.empty() and (run.y != y or run.x0 + static_cast<int>(run.pixels.size()) != x)) run_flush<M>(run);
+    if (run.pixels.empty()) {
+        run.x0 = x;
+        run.y = y;
+    }
+    run.pixels.push_back(argb);
+}
+
+// Blend the part of the run inside the clip rectangle
+template <BlendMode M>
+void Rasterizer::run_flush(CoverageRun& run) {
+    int x0 = std::max(run.x0, m_clip_x0);
+    int x1 = std::min(run.x0 + static_cast<int>(run.pixels.size()) - 1, m_clip_x1);
+    if (x0 <= x1 and m_buffer->is_indexed()) {
+        for (int x = x0; x <= x1; x++) m_buffer->write_pixel<M>(run.pixels[x - run.x0], x, run.y);
+    } else if (x0 <= x1) {
+        blend_pixels<M>(m_buffer->get_row(run.y) + x0, run.pixels.data() + (x0 - run.x0), x1 - x0 + 1);
+    }
+
+    run.pixels.clear();
+}
+
+/**
+ * Axis-aligned rectangle with integer corners (both included): the fill
+ * covers the inside rows with span fills, the outline is two horizontal spans
+ * and two vertical runs between them, so every pixel is written once (a
+ * translucent outline is not blended twice on the corners).
+ */
+template <BlendMode M>
+void Rasterizer::draw_rectangle(int x0, int y0, int x1, int y1, const Color& color,
+                                bool fill, const Color& fill_color) {
+    if (fill) {
+        for (int y = std::max(y0 + 1, m_clip_y0); y <= std::min(y1 - 1, m_clip_y1); y++) {
+            span<M>(x0 + 1, x1 - 1, y, fill_color);
+        }
+    }
+
+    span<M>(x0, x1, y0, color);
+    if (y1 == y0) return;
+    span<M>(x0, x1, y1, color);
+
+    bool left = x0 >= m_clip_x0 and x0 <= m_clip_x1;
+    bool right = x1 != x0 and x1 >= m_clip_x0 and x1 <= m_clip_x1;
+    const uint32_t argb = color.get_pixel_color();
+    for (int y = std::max(y0 + 1, m_clip_y0); y <= std::min(y1 - 1, m_clip_y1); y++) {
+        if (left) m_buffer->write_pixel<M>(argb, x0, y);
+        if (right) m_buffer->write_pixel<M>(argb, x1, y);
+    }
+}
+
+/**
+ * Fill the polygon with the active-edge-table scan converter and blend every
+ * resulting span into the buffer. Only the clipped rows are scanned.
+ */
+template <BlendMode M>
+void Rasterizer::fill_poly(const std::vector<Vec2D>& points, const Color& color) {
+    const auto& spans = m_poly_filler.scan(points, m_clip_y0, m_clip_y1);
+
+    for (const PolygonFiller::Span& s : spans) span<M>(s.x0, s.x1, s.y, color);
+}
+
+/**
+ * Midpoint circle outline: one octant is walked with an integer decision
+ * variable and mirrored 8 ways. Points lying on the axes or on the diagonals
+ * are mirrored onto themselves, so they are plotted only once (a translucent
+ * outline must not be blended twice on the same pixel).
+ */
+template <BlendMode M>
+void Rasterizer::draw_circle_outline(int cx, int cy, int radius, const Color& color) {
+    // Plot (±dx, ±dy) around the center skipping the mirrored duplicates
+    auto plot_mirrored = [&](int dx, int dy) {
+        plot<M>(cx + dx, cy + dy, color);
+        if (dx != 0) plot<M>(cx - dx, cy + dy, color);
+        if (dy != 0) plot<M>(cx + dx, cy - dy, color);
+        if (dx != 0 and dy != 0) plot<M>(cx - dx, cy - dy, color);
+    };
+
+    int x = radius;
+    int y = 0;
+    int d = 1 - radius;  // decision variable
+
+    while (y <= x) {
+        plot_mirrored(x, y);
+        if (x != y) plot_mirrored(y, x);
+
+        y++;
+        if (d < 0) {
+            d += 2 * y + 1;
+        } else {
+            x--;
+            d += 2 * (y - x) + 1;
+        }
+    }
+}
+
+/**
+ * Antialiased circle outline (Xiaolin Wu): for every row y of the first
+ * octant the exact x = sqrt(r^2 - y^2) falls between two pixels weighted by
+ * its fractional part, and the pair is mirrored 8 ways. The octant ends at
+ * y = r / sqrt(2), where x >= y, so only the pixel with x == y can be its own
+ * mirror image across the diagonal.
+ */
+template <BlendMode M>
+void Rasterizer::draw_circle_outline_aa(int cx, int cy, int radius, const Color& color) {
+    const uint32_t argb = color.get_pixel_color();
+
+    auto plot_weighted = [&](int x, int y, uint32_t coverage) {
+        if (inside(x, y)) m_buffer->write_pixel<M>(with_coverage(argb, coverage), x, y);
+    };
+    // Plot (±dx, ±dy) around the center skipping the mirrored duplicates
+    auto plot_mirrored = [&](int dx, int dy, uint32_t coverage) {
+        plot_weighted(cx + dx, cy + dy, coverage);
+        if (dx != 0) plot_weighted(cx - dx, cy + dy, coverage);
+        if (dy != 0) plot_weighted(cx + dx, cy - dy, coverage);
+        if (dx != 0 and dy != 0) plot_weighted(cx - dx, cy - dy, coverage);
+    };
+
+    int64_t r2 = int64_t(radius) * radius;
+    int last_y = static_cast<int>(std::floor(radius / std::sqrt(2.0)));
+
+    for (int y = 0; y <= last_y; y++) {
+        int64_t x_exact = std::llround(std::sqrt(static_cast<double>(r2 - int64_t(y) * y)) * 65536.0);
+        int x = static_cast<int>(x_exact >> 16);
+        uint32_t fraction = static_cast<uint32_t>(x_exact & 0xFFFF) >> 8;
+
+        plot_mirrored(x, y, 255 - fraction);
+        if (x != y) plot_mirrored(y, x, 255 - fraction);
+        if (fraction) {
+            plot_mirrored(x + 1, y, fraction);
+            plot_mirrored(y, x + 1, fraction);
+        }
+    }
+}
+
+/**
+ * Fill the inside of the midpoint circle with symmetric horizontal spans.
+ *
+ * Walking the first octant (x from radius down, y from 0 up):
+ * - the row ±y holds one outline pixel at ±x, so its span half-width is x - 1;
+ * - the row ±x holds the outline pixels from the first y reached with that x,
+ *   so its span half-width is that y - 1 (emitted when x is about to change).
+ * Every row of the circle is emitted exactly once.
+ */
+template <BlendMode M>
+void Rasterizer::fill_circle(int cx, int cy, int radius, const Color& color) {
+    auto mirrored_span = [this, cx, cy, &color](int half_width, int dy) {
+        if (half_width < 0) return;
+        span<M>(cx - half_width, cx + half_width, cy + dy, color);
+        if (dy != 0) span<M>(cx - half_width, cx + half_width, cy - dy, color);
+    };
+
+    int x = radius;
+    int y = 0;
+    int d = 1 - radius;  // decision variable
+    int first_y = 0;     // first y reached with the current x
+
+    while (y <= x) {
+        if (y < x) mirrored_span(x - 1, y);
+
+        int current_x = x;
+        y++;
+        if (d < 0) {
+            d += 2 * y + 1;
+        } else {
+            x--;
+            d += 2 * (y - x) + 1;
+        }
+
+        // Last point with this x: its row is complete
+        if (x != current_x or y > x) {
+            mirrored_span(first_y - 1, current_x);
+            first_y = y;
+        }
+    }
+}
+
+/**
+ * Blit the visible spans of the sprite rows inside the clip rectangle, with
+ * (x, y) the top-left corner. Indexed buffers blend pixel by pixel through
+ * the palette (a copied pixel is a lookup of its nearest entry).
+ */
+template <BlendMode M>
+void Rasterizer::draw_sprite(const Sprite& sprite, int x, int y) {
+    int row0 = std::max(0, m_clip_y0 - y);
+    int row1 = std::min(sprite.height() - 1, m_clip_y1 - y);
+    // Opaque pixels are left as they are by these two modes
+    constexpr bool copies_opaque = M == BlendMode::OPAQUE or M == BlendMode::SOURCE_OVER;
+
+    for (int row = row0; row <= row1; row++) {
+        const uint32_t* pixels = sprite.row_pixels(row);
+        int dst_y = y + row;
+
+        for (const Sprite::Span* span = sprite.spans_begin(row); span != sprite.spans_end(row); span++) {
+            int from = std::max<int>(span->x, m_clip_x0 - x);
+            int to = std::min<int>(span->x + span->length - 1, m_clip_x1 - x);
+            if (from > to) continue;
+            size_t count = to - from + 1;
+
+            if (m_buffer->is_indexed()) {
+                for (int sx = from; sx <= to; sx++) m_buffer->write_pixel<M>(pixels[sx], x + sx, dst_y);
+            } else if (copies_opaque and !span->blend) {
+                std::copy_n(pixels + from, count, m_buffer->get_row(dst_y) + x + from);
+            } else {
+                blend_pixels<M>(m_buffer->get_row(dst_y) + x + from, pixels + from, count);
+            }
+        }
+    }
+}
+
+template <BlendMode M>
+void Rasterizer::draw_text(const TextRun& run, int x, int y, const Color& color) {
+    int row0 = std::max(0, m_clip_y0 - y);
+    int row1 = std::min(run.height - 1, m_clip_y1 - y);
+
+    for (int row = row0; row <= row1; row++) {
+        for (const TextRun::Span* ink = run.spans_begin(row); ink != run.spans_end(row); ink++) {
+            span<M>(x + ink->x, x + ink->x + ink->length - 1, y + row, color);
+        }
+    }
+}
@@ -7,8 +7,10 @@
 
 #include <cmath>
 #include <algorithm>
+#include <cstring>
+#include <thread>
+#include "pixel_scale.h"
 #include "Screen.h"
-#include "graphics_utils.h"
 
 // ========================================================================== //
 // Public interface                                                           //
@@ -17,12 +19,24 @@
 // Constructors ============================================================= //
 
 // Default Constructor
-Screen::Screen() : m_width(0), m_height(0), m_window_ptr(nullptr), m_window_surface_ptr(nullptr)  {}
+Screen::Screen() : m_width(0), m_height(0), m_magnification(1), m_clear_color(Color::BLACK),
+                   m_render_mode(RenderMode::IMMEDIATE), m_antialiasing(false),
+                   m_blend_mode(BlendMode::SOURCE_OVER), m_damage_threshold(0.5f), m_full_present_pending(true),
+                   m_initialized(false), m_headless(false), m_window_ptr(nullptr), m_window_surface_ptr(nullptr), m_direct_present(false),
+                   m_backend(Backend::SURFACE), m_renderer_ptr(nullptr), m_texture_ptr(nullptr), m_present_ms(0.0),
+                   m_render_thread_running(false), m_published_frames(0), m_presented_frames(0), m_dropped_frames(0),
+                   m_handoff_last_ns(0), m_handoff_max_ns(0), m_handoff_total_ns(0),
+                   m_frame_stats(), m_last_frame_stats(), m_render_thread_update_ms(0.0), m_allocation_counter(nullptr),
+                   m_allocations_start(0), m_last_swap(std::chrono::steady_clock::now()), m_stats_overlay(false)  {}
 
 
 // Instance methods ========================================================= //
 
-SDL_Window* Screen::init(uint32_t w, uint32_t h, uint32_t magnification) {
+/**
+ * Open a window magnification times larger than the w x h screen. With the
+ * RENDERER backend, vsync makes every present wait for the display refresh.
+ */
+SDL_Window* Screen::init(uint32_t w, uint32_t h, uint32_t magnification, Backend backend, bool vsync) {
     // Init SDL library
     if (SDL_Init(SDL_INIT_VIDEO)) {
         std::cerr << "Error - SDL could not initialize: " << SDL_GetError() << std::endl;
@@ -32,6 +46,8 @@ SDL_Window* Screen::init(uint32_t w, uint32_t h, uint32_t magnification) {
     // Set width and height
     m_width = w;
     m_height = h;
+    m_magnification = magnification;
+    m_backend = backend;
 
     // SDL Window creation
     m_window_ptr = SDL_CreateWindow(
@@ -48,196 +64,324 @@ SDL_Window* Screen::init(uint32_t w, uint32_t h, uint32_t magnification) {
         return nullptr;
     }
 
-    // Create a surface for the main window
-    m_window_surface_ptr = SDL_GetWindowSurface(m_window_ptr);
-    if (!m_window_surface_ptr) {
-        std::cerr << "Error: Failed to create SDL Window Surface: " << SDL_GetError() << std::endl;
-        SDL_DestroyWindow(m_window_ptr);
-        m_window_ptr = nullptr;
-        SDL_Quit();
-        return nullptr;
+    if (m_backend == Backend::RENDERER) {
+        // A window with a renderer must not use its surface
+        if (!init_renderer(vsync)) {
+            SDL_DestroyWindow(m_window_ptr);
+            m_window_ptr = nullptr;
+            SDL_Quit();
+            return nullptr;
+        }
+        init_buffers();
+    } else {
+        // Create a surface for the main window
+        m_window_surface_ptr = SDL_GetWindowSurface(m_window_ptr);
+        if (!m_window_surface_ptr) {
+            std::cerr << "Error: Failed to create SDL Window Surface: " << SDL_GetError() << std::endl;
+            SDL_DestroyWindow(m_window_ptr);
+            m_window_ptr = nullptr;
+            SDL_Quit();
+            return nullptr;
+        }
+        init_buffers();
+        m_direct_present = window_matches_back_buffer();
     }
 
-    // Init ScreenBuffer
-    m_back_buffer.init(m_width, m_height);
-    
-    // Init color class
-    Color::init_color_format(m_back_buffer.get_surface()->format);
-    m_clear_color = Color::Black();
-
-    // Clear buffer
-    m_back_buffer.clear_surface(m_clear_color);
-
     return m_window_ptr;
 }
 
-void Screen::swap_screens() { // for double-buffering
-    // Check for window initialization
-    if (!m_window_ptr) throw std::runtime_error("Window not initialized!");
-
-    // Clear the current front facing surface (not the back-buffer)
-    clear_screen();  
-
-    // Blit the surface of the screen buffer with the main Window and scale to
-    // match the magnification of the window
-    SDL_BlitScaled(m_back_buffer.get_surface(), nullptr, m_window_surface_ptr, nullptr);
+/**
+ * Init the screen without any window: frames are presented into an in-memory
+ * buffer, see frame(). SDL is not initialized (surfaces do not need it), so
+ * this works on machines without a display.
+ */
+bool Screen::init_headless(uint32_t w, uint32_t h) {
+    m_width = w;
+    m_height = h;
+    m_magnification = 1;
+    m_headless = true;
 
-    SDL_UpdateWindowSurface(m_window_ptr);
+    init_buffers();
+    m_front_buffer.init(m_width, m_height);
 
-    m_back_buffer.clear_surface();
+    return m_back_buffer.get_surface() and m_front_buffer.get_surface();
 }
 
-void Screen::draw(int x, int y, const Color& color) {
-    // Check for window initialization
-    if (!m_window_ptr) throw std::runtime_error("Window not initialized!");
-
-    m_back_buffer.set_pixel(color, x, y);
+/**
+ * Use a pool of thread_count threads (the caller included) for the fills that
+ * can be split in independent tiles. 0 or 1 disables the pool.
+ */
+void Screen::set_raster_threads(unsigned thread_count) {
+    if (thread_count <= 1) {
+        m_thread_pool.reset();
+    } else if (!m_thread_pool or m_thread_pool->size() != thread_count) {
+        m_thread_pool = std::make_unique<ThreadPool>(thread_count);
+    }
+}
 
+const ScreenBuffer& Screen::frame() const {
+    if (!m_headless) throw std::runtime_error("The presented frame is only kept headless!");
+    return m_front_buffer;
 }
 
-void Screen::draw(const Vec2D& point, const Color& color) {
-    // Check for window initialization
-    if (!m_window_ptr) throw std::runtime_error("Window not initialized!");
+/**
+ * FNV-1a hash of the pixels of the presented frame (headless only)
+ */
+uint64_t Screen::frame_hash() const {
+    const ScreenBuffer& presented = frame();
+
+    uint64_t hash = 14695981039346656037ull;
+    for (int y = 0; y < presented.height(); y++) {
+        const uint32_t* row = presented.get_row(y);
+        for (int x = 0; x < presented.width(); x++) {
+            hash = (hash ^ row[x]) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
 
-    m_back_buffer.set_pixel(color, point.get_x(), point.get_y());
+bool Screen::save_frame(const std::string& path) {
+    frame();  // headless check
+    return SDL_SaveBMP(m_front_buffer.get_surface(), path.c_str()) == 0;
 }
 
 /**
- * Draw a line using Bresnham's Algorithm 
+ * Present the back-buffer and start a new frame.
+ *
+ * Only the regions drawn in this frame (new content) and in the previous one
+ * (content to erase) are cleared, blitted and updated on the window. When
+ * they cover more than the damage threshold the whole window is presented.
+ * With a render thread the frame is handed over instead, see
+ * set_render_thread().
  */
-void Screen::draw(const Line2D& line, const Color& color) {
-    // Check for window initialization
-    if (!m_window_ptr) throw std::runtime_error("Window not initialized!");
-
-    int dx, dy;
+void Screen::swap_screens() { // for double-buffering
+    // Check for screen initialization
+    if (!m_initialized) throw std::runtime_error("Screen not initialized!");
 
-    int x0 = roundf(line.get_p0().get_x());
-    int y0 = roundf(line.get_p0().get_y());
-    int x1 = roundf(line.get_p1().get_x());
-    int y1 = roundf(line.get_p1().get_y());
+    GRAPHICS_STATS(if (m_stats_overlay) draw_stats_overlay());
 
-    dx = x1 - x0;
-    dy = y1 - y0;
+    // Replay the recorded commands, then close the frame: the back-buffer
+    // surface is unlocked before the blit
+    {
+        GRAPHICS_STATS(StatsTimer timer(m_frame_stats.raster_ms));
+        flush_draw_list();
+    }
+    m_back_buffer.end_frame();
+    if (m_recorder.is_recording()) m_recorder.push(m_back_buffer);
+
+    if (m_render_thread.joinable()) {
+        hand_over_frame();
+        GRAPHICS_STATS(end_frame_stats());
+        m_back_buffer.begin_frame();
+        return;
+    }
 
-    signed const char ix((dx > 0) - (dx < 0));  // evaluate to 1 or -1 (depends of which direction the line is)
-    signed const char iy((dy > 0) - (dy < 0));
+    m_present_region.clear();
+    m_present_region.add(m_damage);
+    m_present_region.add(m_previous_damage);
+
+    uint64_t present_start = SDL_GetPerformanceCounter();
+    size_t screen_area = static_cast<size_t>(m_width) * m_height;
+    if (m_full_present_pending or m_present_region.area() > m_damage_threshold * screen_area) {
+        present_full();
+        m_full_present_pending = false;
+    } else {
+        present_damage();
+    }
+    m_present_ms = 1000.0 * (SDL_GetPerformanceCounter() - present_start) / SDL_GetPerformanceFrequency();
+    GRAPHICS_STATS(m_frame_stats.blit_ms = m_present_ms - m_frame_stats.update_ms);
 
-    dx = abs(dx) * 2;  // * 2 to get rid of any floating point math
-    dy = abs(dy) * 2;
+    // What has been drawn now must be erased from the window next frame
+    std::swap(m_damage, m_previous_damage);
+    m_damage.clear();
 
-    // Draw the line
-    draw(x0, y0, color); // first point
-    if (dx >= dy) {  // go along in the x direction
-        int d = dy - dx/2;
+    GRAPHICS_STATS(end_frame_stats());
+    m_back_buffer.begin_frame();
+}
 
-        while(x0 != x1) {
-            if(d >= 0) {
-                d -= dx;
-                y0 += iy;
-            }
+/**
+ * Clip every following draw call to the rectangle, until the matching
+ * pop_clip_rect(). Nested rectangles are intersected with the current one.
+ */
+void Screen::push_clip_rect(const SDL_Rect& rect) {
+    // Check for screen initialization
+    if (!m_initialized) throw std::runtime_error("Screen not initialized!");
 
-            d += dy;
-            x0 += ix;
+    const SDL_Rect& current = m_clip_stack.back();
+    int x0 = std::max(rect.x, current.x);
+    int y0 = std::max(rect.y, current.y);
+    int x1 = std::min(rect.x + rect.w, current.x + current.w);
+    int y1 = std::min(rect.y + rect.h, current.y + current.h);
 
-            draw(x0, y0, color);
-        }
-    } else {  // go along in y
-        int d = dx - dy/2;
+    m_clip_stack.push_back({x0, y0, std::max(x1 - x0, 0), std::max(y1 - y0, 0)});
+}
 
-        while(y0 != y1) {
-            if (d >= 0) {
-                d -= dy;
-                x0 += ix;
-            }
+void Screen::pop_clip_rect() {
+    if (m_clip_stack.size() <= 1) throw std::runtime_error("Clip rectangle stack is empty!");
+    m_clip_stack.pop_back();
+}
 
-            d += dx;
-            y0 += iy;
+/**
+ * Switch between immediate, deferred and tiled rendering (see RenderMode).
+ * Going back to immediate replays what has been recorded so far. The tiled
+ * mode starts a pool with a thread per core unless set_raster_threads() has
+ * already set one up; without a pool it replays like the deferred mode.
+ */
+void Screen::set_render_mode(RenderMode mode) {
+    if (mode == RenderMode::IMMEDIATE) flush_draw_list();
+    if (mode == RenderMode::TILED and !m_thread_pool) set_raster_threads(std::thread::hardware_concurrency());
+    m_render_mode = mode;
+}
 
-            draw(x0, y0, color);
+/**
+ * Start or stop the render thread. While it runs, swap_screens() only hands
+ * the frame over through a triple buffer: the thread presents the latest
+ * frame (always the whole of it, skipped frames have no damage to rely on)
+ * while the caller draws the next one, and a slow present never blocks it.
+ * Stopping presents the last frame handed over, then joins the thread.
+ *
+ * SDL renderers must be used by the thread that created them, so the
+ * renderer backend keeps presenting in swap_screens().
+ */
+void Screen::set_render_thread(bool enabled) {
+    // Check for screen initialization
+    if (!m_initialized) throw std::runtime_error("Screen not initialized!");
+    if (enabled == m_render_thread.joinable()) return;
+
+    if (enabled) {
+        if (m_renderer_ptr) throw std::runtime_error("The renderer backend cannot present on a render thread!");
+        if (!m_frames) {
+            m_frames = std::make_unique<TripleBuffer<ScreenBuffer>>();
+            for (unsigned slot = 0; slot < 3; slot++) init_frame_buffer(m_frames->slot(slot));
         }
+        m_render_thread_running = true;
+        m_render_thread = std::thread(&Screen::render_loop, this);
+    } else {
+        m_render_thread_running = false;
+        m_published_frames.fetch_add(1);
+        m_published_frames.notify_one();
+        m_render_thread.join();
+
+        // The window does not match the damage tracking anymore
+        m_damage.clear();
+        m_previous_damage.clear();
+        m_full_present_pending = true;
     }
+}
 
+/**
+ * Switch the back buffer to 8-bit palette indices (or back to ARGB8888 with
+ * nullptr). The pixels are expanded to ARGB when presented. What has been
+ * drawn in the current frame is lost.
+ */
+void Screen::set_palette(std::shared_ptr<const Palette> palette) {
+    if (m_render_thread.joinable()) throw std::runtime_error("Stop the render thread before changing the palette!");
+
+    m_palette = std::move(palette);
+    m_frames.reset();  // render thread slots, created again when needed
+    if (!m_initialized) return;  // applied by init()
+
+    m_draw_list.clear();
+    m_texts.clear();
+    init_frame_buffer(m_back_buffer);
+    m_back_buffer.clear_surface(clear_color());
+    m_back_buffer.begin_frame();
+    if (m_window_surface_ptr) m_direct_present = window_matches_back_buffer();
+    m_full_present_pending = true;
 }
 
-void Screen::draw(const Triangle2D& triangle, const Color& color, bool fill, const Color& fill_color) {
+Screen::HandoffStats Screen::handoff_stats() const {
+    constexpr double NS_PER_MS = 1e6;
+    uint64_t presented = m_presented_frames.load();
+
+    HandoffStats stats;
+    stats.presented = presented;
+    stats.dropped = m_dropped_frames.load();
+    stats.last_ms = m_handoff_last_ns.load() / NS_PER_MS;
+    stats.mean_ms = presented ? m_handoff_total_ns.load() / NS_PER_MS / presented : 0.0;
+    stats.max_ms = m_handoff_max_ns.load() / NS_PER_MS;
+    return stats;
+}
 
-    if (fill) fill_poly(triangle.get_points(), fill_color);
-    
-    // Check for window initialization
-    if (!m_window_ptr) throw std::runtime_error("Window not initialized!");
+bool Screen::start_capture(const std::string& path, FrameRecorder::Format format, unsigned fps) {
+    // Check for screen initialization
+    if (!m_initialized) throw std::runtime_error("Screen not initialized!");
 
-    Line2D p0p1 = Line2D(triangle.get_p0(), triangle.get_p1());
-    Line2D p1p2 = Line2D(triangle.get_p1(), triangle.get_p2());
-    Line2D p2p0 = Line2D(triangle.get_p2(), triangle.get_p0());
+    return m_recorder.start(path, m_width, m_height, format, fps);
+}
 
-    draw(p0p1, color);
-    draw(p1p2, color);
-    draw(p2p0, color);
+void Screen::draw(int x, int y, const Color& color) {
+    // Check for screen initialization
+    if (!m_initialized) throw std::runtime_error("Screen not initialized!");
 
-    
+    submit(DrawCommand::point(x, y, color));
 }
 
-void Screen::draw(const Rectangle2D& rectangle, const Color& color, bool fill, const Color& fill_color) {
-    // Check for window initialization
-    if (!m_window_ptr) throw std::runtime_error("Window not initialized!");
-
-    std::vector<Vec2D> points = rectangle.get_points();
+void Screen::draw(const Vec2D& point, const Color& color) {
+    // Check for screen initialization
+    if (!m_initialized) throw std::runtime_error("Screen not initialized!");
 
-    if (fill) fill_poly(points, fill_color);
+    draw(static_cast<int>(point.get_x()), static_cast<int>(point.get_y()), color);
+}
 
-    Line2D p0p1 = Line2D(points[0], points[1]);
-    Line2D p0p2 = Line2D(points[1], points[2]);
-    Line2D p1p3 = Line2D(points[2], points[3]);
-    Line2D p2p3 = Line2D(points[3], points[0]);
+void Screen::draw(const Line2D& line, const Color& color) {
+    // Check for screen initialization
+    if (!m_initialized) throw std::runtime_error("Screen not initialized!");
 
-    draw(p0p1, color);
-    draw(p0p2, color);
-    draw(p1p3, color);
-    draw(p2p3, color);
+    submit(DrawCommand::line(line.get_p0(), line.get_p1(), color));
 }
 
-void Screen::draw(const Circle2D& circle, const Color& color, bool fill, const Color& fill_color) {
-    // Check for window initialization
-    if (!m_window_ptr) throw std::runtime_error("Window not initialized!");
+void Screen::draw(const Triangle2D& triangle, const Color& color, bool fill, const Color& fill_color) {
+    // Check for screen initialization
+    if (!m_initialized) throw std::runtime_error("Screen not initialized!");
 
-    std::vector<Vec2D> circle_points;  // for poly fill
-    std::vector<Line2D> lines;         // for poly fill
+    submit(DrawCommand::triangle(triangle.get_p0(), triangle.get_p1(), triangle.get_p2(), color, fill, fill_color));
+}
 
-    unsigned number_of_segments = calculate_number_of_segments(circle.get_radius());
-    
-    float angle = (static_cast<float>(M_PI) * 2.0f) / static_cast<float>(number_of_segments);
+void Screen::draw(const Rectangle2D& rectangle, const Color& color, bool fill, const Color& fill_color) {
+    // Check for screen initialization
+    if (!m_initialized) throw std::runtime_error("Screen not initialized!");
+
+    submit(DrawCommand::rectangle(rectangle.get_top_left_point(), rectangle.get_bottom_right_point(),
+                                  color, fill, fill_color));
+}
 
-    Vec2D p0 = Vec2D(circle.get_center_point().get_x() + circle.get_radius(), 
-                     circle.get_center_point().get_y());
-    Vec2D p1 = p0;
-    Line2D next_line;
+void Screen::draw(const Circle2D& circle, const Color& color, bool fill, const Color& fill_color) {
+    // Check for screen initialization
+    if (!m_initialized) throw std::runtime_error("Screen not initialized!");
 
-    for (unsigned i=0; i < number_of_segments; i++) {
-        p1.rotate(angle, circle.get_center_point());
-        next_line.set_p0(p0);
-        next_line.set_p1(p1);
+    submit(DrawCommand::circle(circle.get_center_point(), circle.get_radius(), color, fill, fill_color));
+}
 
-        lines.push_back(next_line);
-        circle_points.push_back(p0);
+void Screen::draw(const Sprite& sprite, int x, int y) {
+    // Check for screen initialization
+    if (!m_initialized) throw std::runtime_error("Screen not initialized!");
+    if (!sprite.is_packed()) throw std::runtime_error("Sprite not packed!");
 
-        p0 = p1;
-    }
+    submit(DrawCommand::sprite(sprite, x, y));
+}
 
-    if (fill) fill_poly(circle_points, fill_color);
+void Screen::draw(BitmapFont& font, const std::string& text, int x, int y, const Color& color) {
+    // Check for screen initialization
+    if (!m_initialized) throw std::runtime_error("Screen not initialized!");
 
-    // Draw the perimeter
-    for (const Line2D& line : lines) draw(line, color);
+    std::shared_ptr<const TextRun> run = font.layout(text);
+    submit(DrawCommand::text(*run, x, y, color));
+    if (m_render_mode != RenderMode::IMMEDIATE) m_texts.push_back(std::move(run));
 }
 
 // Operator overloading ===================================================== //
 
 // Destructor =============================================================== //
 Screen::~Screen() {
+    if (m_render_thread.joinable()) set_render_thread(false);
+    if (m_texture_ptr) SDL_DestroyTexture(m_texture_ptr);
+    if (m_renderer_ptr) SDL_DestroyRenderer(m_renderer_ptr);
     if (m_window_ptr) {
         SDL_DestroyWindow(m_window_ptr);
         m_window_ptr = nullptr;
+        SDL_Quit();  // headless screens never init SDL
     }
-    SDL_Quit();
 }
 // ========================================================================== //
 // Private interface                                                          //
@@ -246,87 +390,400 @@ Screen::~Screen() {
 // Instance methods ========================================================= //
 
 /**
- * This function implements a polygon filling algorithm using the scan-line method.
+ * Create the back-buffer, open the first frame and size the damage tracking
+ * and the draw list. Common to the window and the headless screens.
  */
-void Screen::fill_poly(const std::vector<Vec2D>& points, const Color& color) {
-    if (points.size() == 0) return;
-
-    // Find the Bounding Box of the polygon (find the max/min for x and y component)
-    float top = points[0].get_y();
-    float bottom = points[0].get_y();
-    float right = points[0].get_x();
-    float left = points[0].get_x();
-
-    for (size_t i = 1; i < points.size(); i++) {
-        if (points[i].get_y() < top)  // min
-            top = points[i].get_y();
-        
-        if (points[i].get_y() > bottom)  // max
-            bottom = points[i].get_y();
-
-        if (points[i].get_x() < left)  // min
-            left = points[i].get_x();
-
-        if (points[i].get_x() > right)  // max
-            right = points[i].get_x();
+void Screen::init_frame_buffer(ScreenBuffer& buffer) {
+    if (m_palette) {
+        buffer.init_indexed(m_width, m_height, m_palette);
+    } else {
+        buffer.init(m_width, m_height);
     }
+}
 
-    // Go through the polygon (vertically)
-    for (int pixel_y = top; pixel_y < bottom; pixel_y++) {
-        std::vector<float> node_x_vec;  // intersection points
+void Screen::init_buffers() {
+    // Init ScreenBuffer
+    init_frame_buffer(m_back_buffer);
+    
+    m_clear_color = Color::BLACK;
 
-        // For each pair of consecutive points (points[i] and points[j]), 
-        // the function checks if the horizontal scan line (pixel_y) intersects 
-        // the edge defined by these two points.
-        size_t j = points.size() - 1;
-        for (size_t i = 0; i < points.size(); i++) {
-            float point_iy = points[i].get_y();
-            float point_jy = points[j].get_y();
+    // Clear buffer and open the first frame
+    m_back_buffer.clear_surface(clear_color());
+    m_back_buffer.begin_frame();
+    m_draw_list.set_bounds(m_width, m_height);
 
-            // Check if the scanline intersects the edge
-            if ((point_iy <= static_cast<float>(pixel_y) && point_jy > static_cast<float>(pixel_y)) || 
-                (point_jy <= static_cast<float>(pixel_y) && point_iy > static_cast<float>(pixel_y))) {
+    // The presented content is unknown until the first full present
+    m_damage.set_bounds(m_width, m_height);
+    m_previous_damage.set_bounds(m_width, m_height);
+    m_present_region.set_bounds(m_width, m_height);
+    m_full_present_pending = true;
 
-                    float denom = point_jy - point_iy;
-                    if (is_equal(denom, 0)) continue; // ignore perfectly horizontal edges
+    m_clip_stack.assign(1, {0, 0, static_cast<int>(m_width), static_cast<int>(m_height)});
 
-                    // Linear interpolation
-                    float x = points[i].get_x() + (static_cast<float>(pixel_y) - point_iy) / denom * (points[j].get_x() - points[i].get_x());
+    m_initialized = true;
+}
 
-                    node_x_vec.push_back(x); // all intersection points (node_x_vec) along the scan line are stored.
+/**
+ * Clip the command to the current clip rectangle, reject it when its bounding
+ * box is outside, add what is left to the damage of the frame, then record or
+ * rasterize it
+ */
+void Screen::submit(DrawCommand command) {
+    GRAPHICS_STATS(m_frame_stats.draw_calls[command.type]++);
+    if (command.x0 > command.x1) return;  // nothing to draw (negative radius)
+    command.blend = m_blend_mode;
+    if (m_antialiasing and m_blend_mode != BlendMode::OPAQUE) command.set_antialiased();  // no coverage to blend
+
+    const SDL_Rect& clip = m_clip_stack.back();
+    int x0 = std::max(command.x0, clip.x);
+    int y0 = std::max(command.y0, clip.y);
+    int x1 = std::min(command.x1, clip.x + clip.w - 1);
+    int y1 = std::min(command.y1, clip.y + clip.h - 1);
+    if (x0 > x1 or y0 > y1) return;  // fully clipped
+
+    command.set_clip(clip);
+    m_damage.add(x0, y0, x1, y1);
+
+#ifdef GRAPHICS_ENABLE_STATS
+    bool opaque = command.blend == BlendMode::OPAQUE or (command.blend == BlendMode::SOURCE_OVER and
+                  (command.type == DrawCommand::SPRITE ? !command.sprite_ptr->has_blending() :
+                   !command.antialiased and (command.color >> Color::ALPHA_SHIFT) == 0xFF and
+                   (!command.fill or (command.fill_color >> Color::ALPHA_SHIFT) == 0xFF)));
+    (opaque ? m_frame_stats.pixels_opaque : m_frame_stats.pixels_blended) += command.cost();
+#endif
+
+    if (m_render_mode == RenderMode::IMMEDIATE) {
+        GRAPHICS_STATS(StatsTimer timer(m_frame_stats.raster_ms));
+        raster(command);
+    } else {
+        m_draw_list.add(command);
+    }
+}
+
+/**
+ * Replay the recorded commands that survived culling and the cost budget.
+ *
+ * In tiled mode every bin of the draw list is a task for the pool: a bin is
+ * rasterized by a single thread, in submission order, clipped to its own
+ * pixels, so no two threads ever write the same pixel and the result does
+ * not depend on the scheduling.
+ */
+void Screen::flush_draw_list() {
+    const std::vector<uint32_t>& replay = m_draw_list.prepare();
+
+    if (m_render_mode == RenderMode::TILED and m_thread_pool and !replay.empty()) {
+        m_draw_list.build_bins();
+        m_tile_rasterizers.resize(m_thread_pool->size());
+
+        m_thread_pool->parallel_for(m_draw_list.bin_count(), [this](size_t bin, unsigned thread) {
+            Rasterizer& rasterizer = m_tile_rasterizers[thread];
+            SDL_Rect clip = m_draw_list.bin_rect(bin);
+
+            for (const uint32_t* index = m_draw_list.bin_begin(bin); index != m_draw_list.bin_end(bin); index++) {
+                rasterizer.draw(m_back_buffer, m_draw_list[*index], clip);
             }
-            j = i;
+        });
+    } else {
+        for (uint32_t index : replay) raster(m_draw_list[index]);
+    }
+
+    m_draw_list.clear();
+    m_texts.clear();
+}
+
+void Screen::raster(const DrawCommand& command) {
+    SDL_Rect clip = {0, 0, static_cast<int>(m_width), static_cast<int>(m_height)};
+    m_rasterizer.draw(m_back_buffer, command, clip, m_thread_pool.get());
+}
+
+void Screen::present_full() {
+    present_frame(m_back_buffer);
+    m_back_buffer.clear_surface(clear_color());
+}
+
+// Present the whole frame (the back buffer, or a frame of the render thread)
+void Screen::present_frame(ScreenBuffer& frame) {
+    SDL_Rect rect = {0, 0, static_cast<int>(m_width), static_cast<int>(m_height)};
+
+    if (m_headless) {
+        m_front_buffer.copy_rect(frame, rect);
+    } else if (m_renderer_ptr) {
+        upload_to_texture(frame, rect);
+        render_texture();
+    } else {
+        if (m_direct_present) {
+            scale_to_window(frame, rect);
+        } else {
+            // Clear the current front facing surface (not the back-buffer)
+            clear_screen();
+
+            // Blit the surface of the screen buffer with the main Window and scale to
+            // match the magnification of the window
+            SDL_BlitScaled(frame.get_surface(), nullptr, m_window_surface_ptr, nullptr);
         }
 
-        // Sort points in ascending order (to draw a line from left to right)
-        std::sort(node_x_vec.begin(), node_x_vec.end(), std::less<>());
+        GRAPHICS_STATS(StatsTimer timer(update_ms_counter()));
+        SDL_UpdateWindowSurface(m_window_ptr);
+    }
+}
 
-        // Draw the line
-        if (node_x_vec.size() % 2 != 0) continue; // ensure valid pairs
-        for (size_t k = 0; k < node_x_vec.size(); k += 2) {
-            if (node_x_vec[k] > right) break;
+/**
+ * Publish the finished back buffer to the render thread and draw the next
+ * frame in the slot given back, which holds an old frame: clear it all
+ */
+void Screen::hand_over_frame() {
+    m_back_buffer.swap(m_frames->back());
+    if (!m_frames->publish()) m_dropped_frames++;
 
-            // Adjust the fill range to avoid filling the left and right borders
-            int start_x = static_cast<int>(std::ceil(node_x_vec[k])); // round up to avoid covering the left border
-            int end_x = static_cast<int>(std::floor(node_x_vec[k + 1])); // round down to avoid covering the right border
+    m_published_frames.fetch_add(1, std::memory_order_release);
+    m_published_frames.notify_one();
 
-            // Clamp to the bounding box
-            start_x = std::max(start_x, static_cast<int>(left) + 1); // start just after the left border
-            end_x = std::min(end_x, static_cast<int>(right) - 1); // stop just before the right border
+    m_back_buffer.clear_surface(clear_color());
+    m_damage.clear();
+}
 
-            // Ensure valid range
-            if (start_x <= end_x) {
-                for (int pixel_x = start_x; pixel_x <= end_x; pixel_x++) {
-                    draw(pixel_x, pixel_y, color);
-                }
-            }
+/**
+ * Body of the render thread: sleep until a frame is published, present the
+ * latest one, repeat. The published counter is read before trying to take a
+ * frame, so a frame published in between wakes the wait right away.
+ */
+void Screen::render_loop() {
+    uint32_t published = m_published_frames.load(std::memory_order_acquire);
+
+    while (true) {
+        bool running = m_render_thread_running.load();
+
+        if (m_frames->acquire()) {
+            int64_t handoff_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(m_frames->handoff_latency()).count();
+            m_handoff_last_ns = handoff_ns;
+            m_handoff_total_ns += handoff_ns;
+            if (handoff_ns > m_handoff_max_ns.load()) m_handoff_max_ns = handoff_ns;  // single writer
+
+            uint64_t present_start = SDL_GetPerformanceCounter();
+            present_frame(m_frames->front());
+            m_present_ms = 1000.0 * (SDL_GetPerformanceCounter() - present_start) / SDL_GetPerformanceFrequency();
+            m_presented_frames++;
+        } else if (running) {
+            m_published_frames.wait(published, std::memory_order_acquire);
+            published = m_published_frames.load(std::memory_order_acquire);
+        } else {
+            break;  // stopped, and the last frame has been presented
         }
     }
 }
 
-void Screen::clear_screen() {
+/**
+ * Close the counters of the frame: they become the frame_stats() and the
+ * next frame starts from zero
+ */
+void Screen::end_frame_stats() {
+    auto now = std::chrono::steady_clock::now();
+    m_frame_stats.frame_ms = std::chrono::duration<double, std::milli>(now - m_last_swap).count();
+    m_last_swap = now;
+
+    if (m_allocation_counter) {
+        uint64_t allocations = m_allocation_counter();
+        m_frame_stats.allocations = allocations - m_allocations_start;
+        m_allocations_start = allocations;
+    }
+
+    m_last_frame_stats = m_frame_stats;
+    m_frame_stats = FrameStats();
+}
+
+/**
+ * Frame time bars of the last frame in the top-left corner: raster, blit and
+ * window update times one after the other (orange, cyan, green) and the whole
+ * frame time below (gray), on a scale where the white tick is the 60 FPS
+ * budget. The bars are draw calls of the current frame, counted as such.
+ */
+void Screen::draw_stats_overlay() {
+    constexpr double BUDGET_MS = 1000.0 / 60.0;
+    const float budget_width = m_width / 2.0f;
+    const float max_x = m_width - 3.0f;
+    const FrameStats& stats = m_last_frame_stats;
+
+    m_clip_stack.push_back({0, 0, static_cast<int>(m_width), static_cast<int>(m_height)});
+    BlendMode blend_mode = m_blend_mode;
+    m_blend_mode = BlendMode::SOURCE_OVER;
+
+    auto bar = [&](float& x, float y, double ms, const Color& color) {
+        float end = std::min(x + static_cast<float>(ms / BUDGET_MS * budget_width), max_x);
+        if (end > x) submit(DrawCommand::rectangle(Vec2D(x, y), Vec2D(end, y + 2), color, true, color));
+        x = end;
+    };
+    float x = 2.0f;
+    bar(x, 2.0f, stats.raster_ms, Color::Orange());
+    bar(x, 2.0f, stats.blit_ms, Color::Cyan());
+    bar(x, 2.0f, stats.update_ms, Color::Green());
+    x = 2.0f;
+    bar(x, 6.0f, stats.frame_ms, Color::Gray());
+
+    float tick = 2.0f + budget_width;
+    submit(DrawCommand::line(Vec2D(tick, 1.0f), Vec2D(tick, 9.0f), Color::White()));
+
+    m_blend_mode = blend_mode;
+    m_clip_stack.pop_back();
+}
+
+void Screen::present_damage() {
+    if (m_headless) {
+        for (const SDL_Rect& rect : m_present_region.rects()) m_front_buffer.copy_rect(m_back_buffer, rect);
+    } else if (m_renderer_ptr) {
+        // The texture keeps the pixels outside of the locked rects, but the
+        // renderer does not keep its frame: copy the whole texture every time
+        // (which also keeps the vsync pacing when nothing changed)
+        for (const SDL_Rect& rect : m_present_region.rects()) upload_to_texture(m_back_buffer, rect);
+        render_texture();
+    } else if (!m_present_region.empty()) {
+        present_damage_to_window();
+    }
+
+    // Outside of the damage the back-buffer is still clear
+    uint32_t clear_argb = m_clear_color.load(std::memory_order_relaxed);
+    uint32_t clear_pixel = m_palette ? m_palette->index_of(clear_argb) : clear_argb;
+    for (const SDL_Rect& rect : m_damage.rects()) {
+        SDL_FillRect(m_back_buffer.get_surface(), &rect, clear_pixel);
+    }
+}
+
+void Screen::present_damage_to_window() {
+    m_window_rects.clear();
+    for (const SDL_Rect& rect : m_present_region.rects()) {
+        SDL_Rect window_rect = {
+            rect.x * static_cast<int>(m_magnification),
+            rect.y * static_cast<int>(m_magnification),
+            rect.w * static_cast<int>(m_magnification),
+            rect.h * static_cast<int>(m_magnification)
+        };
+        if (m_direct_present) {
+            scale_to_window(m_back_buffer, rect);
+        } else {
+            clear_screen(&window_rect);
+            SDL_BlitScaled(m_back_buffer.get_surface(), &rect, m_window_surface_ptr, &window_rect);
+        }
+
+        m_window_rects.push_back(window_rect);
+    }
+
+    GRAPHICS_STATS(StatsTimer timer(update_ms_counter()));
+    SDL_UpdateWindowSurfaceRects(m_window_ptr, m_window_rects.data(), static_cast<int>(m_window_rects.size()));
+}
+
+/**
+ * Create the renderer, an accelerated one when there is a GPU and the
+ * software one otherwise, and the streaming texture the back buffer is
+ * uploaded to. The texture is sampled nearest-neighbour, like the surface
+ * backend magnifies.
+ */
+bool Screen::init_renderer(bool vsync) {
+    uint32_t vsync_flag = vsync ? SDL_RENDERER_PRESENTVSYNC : 0;
+
+    m_renderer_ptr = SDL_CreateRenderer(m_window_ptr, -1, SDL_RENDERER_ACCELERATED | vsync_flag);
+    if (!m_renderer_ptr) {
+        std::cerr << "Warning - No accelerated renderer (" << SDL_GetError() << "), using the software one" << std::endl;
+        m_renderer_ptr = SDL_CreateRenderer(m_window_ptr, -1, SDL_RENDERER_SOFTWARE | vsync_flag);
+    }
+    if (!m_renderer_ptr) {
+        std::cerr << "Error - Could not create the renderer: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0");  // nearest, read at texture creation
+    m_texture_ptr = SDL_CreateTexture(m_renderer_ptr, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                      static_cast<int>(m_width), static_cast<int>(m_height));
+    if (!m_texture_ptr) {
+        std::cerr << "Error - Could not create the streaming texture: " << SDL_GetError() << std::endl;
+        SDL_DestroyRenderer(m_renderer_ptr);
+        m_renderer_ptr = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Copy the rect of the frame into the streaming texture. The locked
+ * pixels are write-only (their old content is undefined), so all of them
+ * are written.
+ */
+void Screen::upload_to_texture(ScreenBuffer& frame, const SDL_Rect& rect) {
+    void* pixels;
+    int pitch;
+    if (SDL_LockTexture(m_texture_ptr, &rect, &pixels, &pitch) != 0) return;
+
+    for (int row = 0; row < rect.h; row++) {
+        uint32_t* texture_row = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pixels) + row * pitch);
+        if (frame.is_indexed()) {
+            expand_indexed(frame.get_index_row(rect.y + row) + rect.x, frame.palette()->colors(), texture_row, rect.w);
+        } else {
+            std::memcpy(texture_row, frame.get_row(rect.y + row) + rect.x, rect.w * sizeof(uint32_t));
+        }
+    }
+
+    SDL_UnlockTexture(m_texture_ptr);
+}
+
+// Magnify the texture to the whole window and present it
+void Screen::render_texture() {
+    SDL_RenderCopy(m_renderer_ptr, m_texture_ptr, nullptr, nullptr);
+
+    GRAPHICS_STATS(StatsTimer timer(update_ms_counter()));
+    SDL_RenderPresent(m_renderer_ptr);
+}
+
+/**
+ * The back buffer can be copied to the window as it is when the window
+ * surface has the same 32 bit channel layout (ARGB8888 or XRGB8888, the
+ * usual window format: the alpha byte is ignored) and exactly the magnified
+ * size. Otherwise SDL_BlitScaled converts and scales it.
+ */
+bool Screen::window_matches_back_buffer() {
+    const SDL_PixelFormat* window_format = m_window_surface_ptr->format;
+    const SDL_PixelFormat* buffer_format = m_back_buffer.get_surface()->format;
+
+    // Indexed buffers are expanded to the channel layout of Color
+    bool same_layout = m_back_buffer.is_indexed() ?
+        window_format->Rmask == 0x00FF0000 and window_format->Gmask == 0x0000FF00 and window_format->Bmask == 0x000000FF :
+        buffer_format->BytesPerPixel == 4 and window_format->Rmask == buffer_format->Rmask and
+        window_format->Gmask == buffer_format->Gmask and window_format->Bmask == buffer_format->Bmask;
+
+    return window_format->BytesPerPixel == 4 and same_layout and
+           m_window_surface_ptr->w == static_cast<int>(m_width * m_magnification) and
+           m_window_surface_ptr->h == static_cast<int>(m_height * m_magnification);
+}
+
+/**
+ * Magnify the rect of the frame into the window surface: one read of
+ * the back buffer and one write of the window per pixel. Every window pixel
+ * of the rect is overwritten, so it does not need to be cleared first.
+ */
+void Screen::scale_to_window(ScreenBuffer& frame, const SDL_Rect& rect) {
+    SDL_Surface* buffer = frame.get_surface();
+    bool lock = SDL_MUSTLOCK(m_window_surface_ptr);
+    if (lock and SDL_LockSurface(m_window_surface_ptr) != 0) return;
+
+    if (frame.is_indexed()) {
+        scale_nearest_indexed(buffer->pixels, buffer->pitch, frame.palette()->colors(), m_window_surface_ptr->pixels,
+                              m_window_surface_ptr->pitch, rect.x, rect.y, rect.w, rect.h, static_cast<int>(m_magnification));
+    } else {
+        scale_nearest(buffer->pixels, buffer->pitch, m_window_surface_ptr->pixels, m_window_surface_ptr->pitch,
+                      rect.x, rect.y, rect.w, rect.h, static_cast<int>(m_magnification));
+    }
+
+    if (lock) SDL_UnlockSurface(m_window_surface_ptr);
+}
+
+void Screen::clear_screen(const SDL_Rect* rect) {
     // Check for window initialization
     if (!m_window_ptr) throw std::runtime_error("Window not initialized!");  
 
-    SDL_FillRect(m_window_surface_ptr, nullptr, m_clear_color.get_pixel_color());
+    // The window surface format is chosen by SDL: map the ARGB color into it
+    Color color = clear_color();  // set by the game thread, read here by the render thread too
+    uint32_t clear_pixel = SDL_MapRGBA(m_window_surface_ptr->format,
+                                       color.get_red(),
+                                       color.get_green(),
+                                       color.get_blue(),
+                                       color.get_alpha());
+    SDL_FillRect(m_window_surface_ptr, rect, clear_pixel);
 }
\ No newline at end of file
@@ -4,75 +4,92 @@
  * @author SimoX
  * @date 2024-10-24
  */
+#include <algorithm>
+#include <cstring>
+#include "pixel_scale.h"
 #include "ScreenBuffer.h"
+#include "SurfacePool.h"
 
 // ========================================================================== //
 // Public interface                                                           //
 // ========================================================================== //
 
+// Class variables ========================================================== //
+std::atomic<uint64_t> ScreenBuffer::s_deep_copies{0};
+
 // Constructors ============================================================= //
-ScreenBuffer::ScreenBuffer() : m_surface_ptr(nullptr), m_surface_area(0) {}
+ScreenBuffer::ScreenBuffer() : m_surface_ptr(nullptr), m_surface_area(0), m_in_frame(false) {}
 
 // Copy constructor
-ScreenBuffer::ScreenBuffer(const ScreenBuffer& screen_buff) { 
-    m_surface_ptr = SDL_CreateRGBSurfaceWithFormat(
-        0,
-        screen_buff.m_surface_ptr->w,
-        screen_buff.m_surface_ptr->h,
-        0,
-        screen_buff.m_surface_ptr->format->format
-    );
-
-    if (!m_surface_ptr) {
-        std::cerr << "Error: Failed to create RGBA surface: " << SDL_GetError() << std::endl;
-        SDL_Quit();
-        exit(1);
-    }
-
-    SDL_BlitSurface(screen_buff.m_surface_ptr, nullptr, m_surface_ptr, nullptr);  // copy all the pixels
-} 
+ScreenBuffer::ScreenBuffer(const ScreenBuffer& screen_buff) : m_surface_ptr(nullptr), m_surface_area(0), m_in_frame(false) {
+    copy_from(screen_buff);
+}
 
+// Move constructor
+ScreenBuffer::ScreenBuffer(ScreenBuffer&& screen_buff) noexcept : m_surface_ptr(screen_buff.m_surface_ptr),
+                                                                 m_palette(std::move(screen_buff.m_palette)),
+                                                                 m_surface_area(screen_buff.m_surface_area),
+                                                                 m_in_frame(screen_buff.m_in_frame) {
+    screen_buff.m_surface_ptr = nullptr;
+    screen_buff.m_surface_area = 0;
+    screen_buff.m_in_frame = false;
+}
 
 // Instance methods ========================================================= //
 
 void ScreenBuffer::init(uint32_t width, uint32_t height, bool alpha_channel) {
     //m_surface_ptr = SDL_CreateRGBSurfaceWithFormat(0, width, height, 0, format);
 
-    if (alpha_channel) {
-        m_surface_ptr = SDL_CreateRGBSurface(
-            0,
-            width,
-            height,
-            32,
-            0x00FF0000,  // R mask
-            0x0000FF00,  // G mask
-            0x000000FF,  // B mask
-            0xFF000000   // A mask
-        ); 
-    } else {
-        m_surface_ptr = SDL_CreateRGBSurface(0, width, height, 32, 0, 0, 0, 0);
+    // Both layouts keep the channels where Color stores them (ARGB8888 and
+    // XRGB8888), so colors are written to the pixels without any conversion
+    release_surface();
+    m_surface_ptr = SurfacePool::shared().acquire(width, height,
+                                                  alpha_channel ? SDL_PIXELFORMAT_ARGB8888 : SDL_PIXELFORMAT_RGB888);
+    if (!m_surface_ptr) {
+        std::cerr << "Error: Failed to create RGBA surface: " << SDL_GetError() << std::endl;
+        SDL_Quit();
+        exit(1);
     }
 
     SDL_PixelFormat* pixel_format_ptr = m_surface_ptr->format;
     std::cout << "The RGBA surface pixel format is: "
               << SDL_GetPixelFormatName(pixel_format_ptr->format) << std::endl;  // SDL_PIXELFORMAT_ARGB8888
 
+    clear_surface();
+
+    // Update area size
+    m_surface_area = m_surface_ptr->w * m_surface_ptr->h;
+}
 
+/**
+ * One byte per pixel, with the palette also copied into the SDL surface so
+ * that SDL blits of the surface show the right colors
+ */
+void ScreenBuffer::init_indexed(uint32_t width, uint32_t height, std::shared_ptr<const Palette> palette) {
+    release_surface();
+    m_surface_ptr = SurfacePool::shared().acquire(width, height, SDL_PIXELFORMAT_INDEX8);
     if (!m_surface_ptr) {
-        std::cerr << "Error: Failed to create RGBA surface: " << SDL_GetError() << std::endl;
+        std::cerr << "Error: Failed to create indexed surface: " << SDL_GetError() << std::endl;
         SDL_Quit();
         exit(1);
     }
+    m_palette = std::move(palette);
 
-    clear_surface();
+    SDL_Color sdl_colors[Palette::MAX_COLORS];
+    for (int i = 0; i < Palette::MAX_COLORS; i++) {
+        Color color(m_palette->color(i));
+        sdl_colors[i] = {color.get_red(), color.get_green(), color.get_blue(), 0xFF};
+    }
+    SDL_SetPaletteColors(m_surface_ptr->format->palette, sdl_colors, 0, Palette::MAX_COLORS);
 
-    // Update area size
+    clear_surface();
     m_surface_area = m_surface_ptr->w * m_surface_ptr->h;
 }
 
 void ScreenBuffer::clear_surface(const Color& c) {
     if (m_surface_ptr) {
-        SDL_FillRect(m_surface_ptr, nullptr, c.get_pixel_color());
+        uint32_t pixel = m_palette ? m_palette->index_of(c.get_pixel_color()) : c.get_pixel_color();
+        SDL_FillRect(m_surface_ptr, nullptr, pixel);
     } else {
         throw std::runtime_error("Surface not found!");
     }
@@ -86,61 +103,147 @@ void ScreenBuffer::clear_surface(const Color& c) {
  */
 void ScreenBuffer::set_pixel(const Color& color, int x, int y) {
     // check surface
-    if (!m_surface_ptr) std::runtime_error("Surface not found!");
+    if (!m_surface_ptr) throw std::runtime_error("Surface not found!");
     // check boudaries
-    if (!((y >= 0 and y < m_surface_ptr->h) and (x >= 0 and x < m_surface_ptr->w))) 
-        std::runtime_error("Pixel out of boudaries!");
+    if (!contains(x, y)) return;
+
+    // Exclusive access to the surface until Unlock (only outside of a frame)
+    bool must_lock = !m_in_frame and SDL_MUSTLOCK(m_surface_ptr);
+    if (must_lock) SDL_LockSurface(m_surface_ptr);
+
+    blend_pixel(color, x, y);
+
+    if (must_lock) SDL_UnlockSurface(m_surface_ptr);
+}
+
+/**
+ * Lock the surface once for the whole frame. While in a frame the row pointers
+ * returned by get_row() stay valid and the span writers skip any locking.
+ */
+void ScreenBuffer::begin_frame() {
+    if (!m_surface_ptr) throw std::runtime_error("Surface not found!");
+    if (m_in_frame) return;
 
-    // Exclusive access to the surface until Unlock
     if (SDL_MUSTLOCK(m_surface_ptr)) SDL_LockSurface(m_surface_ptr);
+    m_in_frame = true;
+}
 
-    uint32_t* pixels = (uint32_t*)m_surface_ptr->pixels;  // 1D array (buffer)
-    
-    auto index_position = get_index(y, x);
-    if(index_position < m_surface_area) {
-        // pixels[index_position] = color.get_pixel_color();
-        Color surface_color = Color(pixels[index_position]);  // dest color
-        pixels[index_position] = Color::alpha_blending(color, surface_color).get_pixel_color();
-    }
-    // else
-    //     std::cout << "index: " << index_position << " out of area: " << m_surface_area << std::endl;
+void ScreenBuffer::end_frame() {
+    if (!m_in_frame) return;
 
     if (SDL_MUSTLOCK(m_surface_ptr)) SDL_UnlockSurface(m_surface_ptr);
+    m_in_frame = false;
 }
 
-// Operator overloading ===================================================== //
-ScreenBuffer& ScreenBuffer::operator=(const ScreenBuffer& screen_buff) {
-    if (this == &screen_buff) return *this;
+/**
+ * Write the color on the row y from x0 to x1 (both included) without blending
+ */
+void ScreenBuffer::fill_span(int x0, int x1, int y, const Color& c) {
+    if (y < 0 or y >= m_surface_ptr->h) return;
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, m_surface_ptr->w - 1);
+    if (x0 > x1) return;
 
-    if (m_surface_ptr) {
-        SDL_FreeSurface(m_surface_ptr);
-        m_surface_ptr = nullptr;
+    if (m_palette) {
+        std::fill_n(get_index_row(y) + x0, x1 - x0 + 1, m_palette->index_of(c.get_pixel_color()));
+        return;
+    }
+    std::fill_n(get_row(y) + x0, x1 - x0 + 1, c.get_pixel_color());
+}
+
+/**
+ * Blend the color on the row y from x0 to x1 (both included) in the mode M.
+ * Indexed pixels use the blend table of the color for SOURCE_OVER; in the
+ * other modes every destination index is blended once per span.
+ */
+template <BlendMode M>
+void ScreenBuffer::write_span(int x0, int x1, int y, uint32_t argb) {
+    if (y < 0 or y >= m_surface_ptr->h) return;
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, m_surface_ptr->w - 1);
+    if (x0 > x1) return;
+
+    if (!m_palette) {
+        blend_solid<M>(get_row(y) + x0, x1 - x0 + 1, argb);
+        return;
     }
 
-    if (screen_buff.m_surface_ptr != nullptr) {
-        m_surface_ptr = SDL_CreateRGBSurfaceWithFormat(
-            0,
-            screen_buff.m_surface_ptr->w,
-            screen_buff.m_surface_ptr->h,
-            0,
-            screen_buff.m_surface_ptr->format->format
-        );
-
-        if (!m_surface_ptr) {
-            std::cerr << "Error: Failed to create RGBA surface: " << SDL_GetError() << std::endl;
-            SDL_Quit();
-            exit(1);
+    uint8_t* row = get_index_row(y);
+    if constexpr (M == BlendMode::OPAQUE) {
+        std::fill(row + x0, row + x1 + 1, m_palette->index_of(argb));
+    } else if constexpr (M == BlendMode::SOURCE_OVER) {
+        uint32_t level = Palette::alpha_level(argb >> Color::ALPHA_SHIFT);
+        if (level == Palette::ALPHA_LEVELS) {
+            std::fill(row + x0, row + x1 + 1, m_palette->index_of(argb));
+        } else if (level > 0) {
+            const uint8_t* table = m_palette->blend_table(m_palette->index_of(argb), level);
+            for (int x = x0; x <= x1; x++) row[x] = table[row[x]];
         }
+    } else {
+        int16_t blended[Palette::MAX_COLORS];
+        std::fill_n(blended, Palette::MAX_COLORS, -1);
+        for (int x = x0; x <= x1; x++) {
+            if (blended[row[x]] < 0) blended[row[x]] = blend_index<M>(argb, row[x]);
+            row[x] = static_cast<uint8_t>(blended[row[x]]);
+        }
+    }
+}
 
-        SDL_BlitSurface(screen_buff.m_surface_ptr, nullptr, m_surface_ptr, nullptr);  // copy all the pixels
+/**
+ * Copy the pixels of the rectangle (clipped) from the source buffer, row by
+ * row. Neither buffer has to be inside a frame: their surfaces never need a
+ * lock (no RLE). Indexed pixels are expanded through the palette of the
+ * source when the destination is ARGB, and mapped to the palette of the
+ * destination in the other direction.
+ */
+void ScreenBuffer::copy_rect(const ScreenBuffer& source, const SDL_Rect& rect) {
+    int x0 = std::max(rect.x, 0);
+    int y0 = std::max(rect.y, 0);
+    int x1 = std::min({rect.x + rect.w, width(), source.width()});
+    int y1 = std::min({rect.y + rect.h, height(), source.height()});
+    if (x0 >= x1 or y0 >= y1) return;
+
+    for (int y = y0; y < y1; y++) {
+        if (source.m_palette and m_palette) {
+            std::copy_n(source.get_index_row(y) + x0, x1 - x0, get_index_row(y) + x0);
+        } else if (source.m_palette) {
+            expand_indexed(source.get_index_row(y) + x0, source.m_palette->colors(), get_row(y) + x0, x1 - x0);
+        } else if (m_palette) {
+            const uint32_t* from = source.get_row(y);
+            uint8_t* to = get_index_row(y);
+            for (int x = x0; x < x1; x++) to[x] = m_palette->index_of(from[x]);
+        } else {
+            std::copy_n(source.get_row(y) + x0, x1 - x0, get_row(y) + x0);
+        }
     }
-    
+}
+
+void ScreenBuffer::swap(ScreenBuffer& other) noexcept {
+    std::swap(m_surface_ptr, other.m_surface_ptr);
+    std::swap(m_palette, other.m_palette);
+    std::swap(m_surface_area, other.m_surface_area);
+    std::swap(m_in_frame, other.m_in_frame);
+}
+
+// Operator overloading ===================================================== //
+ScreenBuffer& ScreenBuffer::operator=(const ScreenBuffer& screen_buff) {
+    if (this == &screen_buff) return *this;
+
+    copy_from(screen_buff);
+    return *this;
+}
+
+ScreenBuffer& ScreenBuffer::operator=(ScreenBuffer&& screen_buff) noexcept {
+    if (this == &screen_buff) return *this;
+
+    release_surface();
+    swap(screen_buff);
     return *this;
 }
 
 // Destructor =============================================================== //
 ScreenBuffer::~ScreenBuffer() {
-    if (m_surface_ptr) SDL_FreeSurface(m_surface_ptr);
+    release_surface();
 }
 
 // ========================================================================== //
@@ -149,11 +252,51 @@ ScreenBuffer::~ScreenBuffer() {
 
 // Instance methods ========================================================= //
 
+// Give the surface back to the pool, the buffer is empty afterwards
+void ScreenBuffer::release_surface() {
+    end_frame();
+    SurfacePool::shared().release(m_surface_ptr);
+    m_surface_ptr = nullptr;
+    m_palette.reset();
+    m_surface_area = 0;
+}
+
 /**
- * Transform 2D index in 1D index
+ * Deep copy: a surface of the same size and format from the pool, the pixels
+ * copied row by row (and the SDL palette of an indexed surface). Counted by
+ * deep_copies(), since buffers are meant to be moved.
  */
-size_t ScreenBuffer::get_index(int row, int col) {
-    if (!m_surface_ptr) std::runtime_error("Surface not found!");
+void ScreenBuffer::copy_from(const ScreenBuffer& other) {
+    release_surface();
+    if (!other.m_surface_ptr) return;
+
+    s_deep_copies.fetch_add(1, std::memory_order_relaxed);
+
+    SDL_Surface* source = other.m_surface_ptr;
+    m_surface_ptr = SurfacePool::shared().acquire(source->w, source->h, source->format->format);
+    if (!m_surface_ptr) {
+        std::cerr << "Error: Failed to create RGBA surface: " << SDL_GetError() << std::endl;
+        SDL_Quit();
+        exit(1);
+    }
+
+    const size_t row_bytes = static_cast<size_t>(source->w) * source->format->BytesPerPixel;
+    for (int y = 0; y < source->h; y++) {
+        std::memcpy(static_cast<uint8_t*>(m_surface_ptr->pixels) + y * m_surface_ptr->pitch,
+                    static_cast<const uint8_t*>(source->pixels) + y * source->pitch, row_bytes);
+    }
+    if (source->format->palette) {
+        SDL_SetPaletteColors(m_surface_ptr->format->palette, source->format->palette->colors, 0,
+                             source->format->palette->ncolors);
+    }
+
+    m_palette = other.m_palette;
+    m_surface_area = other.m_surface_area;
+}
 
-    return m_surface_ptr->w * row + col;
-}
\ No newline at end of file
+// Explicit instantiations ================================================== //
+template void ScreenBuffer::write_span<BlendMode::OPAQUE>(int, int, int, uint32_t);
+template void ScreenBuffer::write_span<BlendMode::SOURCE_OVER>(int, int, int, uint32_t);
+template void ScreenBuffer::write_span<BlendMode::ADDITIVE>(int, int, int, uint32_t);
+template void ScreenBuffer::write_span<BlendMode::MULTIPLY>(int, int, int, uint32_t);
+template void ScreenBuffer::write_span<BlendMode::XOR>(int, int, int, uint32_t);
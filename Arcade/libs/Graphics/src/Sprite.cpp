@@ -0,0 +1,236 @@
+/**
+ * @file Sprite.cpp
+ * @brief Bitmaps packed into a SpriteAtlas and blitted by the Screen.
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include "Sprite.h"
+
+namespace {
+
+constexpr uint32_t RGB_MASK = 0x00FFFFFF;
+constexpr uint32_t ALPHA_MASK = 0xFF000000;
+
+enum PixelKind {SKIP, COPY, BLEND};
+
+}  // namespace
+
+// ========================================================================== //
+// Sprite                                                                     //
+// ========================================================================== //
+
+// Constructors ============================================================= //
+Sprite::Sprite() : m_rect({0, 0, 0, 0}), m_mode(BlitMode::OPAQUE), m_key(0), m_pixels(nullptr), m_pitch(0),
+                   m_row_start(1, 0), m_visible_pixels(0), m_blending(false) {}
+
+// Instance methods ========================================================= //
+
+/**
+ * Split every row in runs of pixels of the same kind (skipped, copied or
+ * blended) and keep the visible ones
+ */
+void Sprite::build_spans() {
+    auto kind_of = [this](uint32_t argb) {
+        switch (m_mode) {
+            case BlitMode::OPAQUE:
+                return COPY;
+            case BlitMode::COLOR_KEY:
+                return (argb & RGB_MASK) == m_key ? SKIP : COPY;
+            case BlitMode::ALPHA: {
+                uint32_t alpha = argb >> Color::ALPHA_SHIFT;
+                return alpha == 0 ? SKIP : alpha == 255 ? COPY : BLEND;
+            }
+        }
+        return COPY;
+    };
+
+    m_spans.clear();
+    m_row_start.assign(1, 0);
+    m_visible_pixels = 0;
+    m_blending = false;
+
+    for (int row = 0; row < m_rect.h; row++) {
+        const uint32_t* pixels = row_pixels(row);
+        int x = 0;
+        while (x < m_rect.w) {
+            PixelKind kind = kind_of(pixels[x]);
+            int end = x + 1;
+            while (end < m_rect.w and kind_of(pixels[end]) == kind) end++;
+
+            if (kind != SKIP) {
+                m_spans.push_back({static_cast<uint16_t>(x), static_cast<uint16_t>(end - x), kind == BLEND});
+                m_visible_pixels += end - x;
+                m_blending = m_blending or kind == BLEND;
+            }
+            x = end;
+        }
+        m_row_start.push_back(static_cast<uint32_t>(m_spans.size()));
+    }
+}
+
+// ========================================================================== //
+// SpriteAtlas                                                                //
+// ========================================================================== //
+
+// Constructors ============================================================= //
+SpriteAtlas::SpriteAtlas() : m_atlas_ptr(nullptr) {}
+
+// Instance methods ========================================================= //
+
+int SpriteAtlas::load_bmp(const std::string& path, Sprite::BlitMode mode, const Color& key) {
+    if (is_packed()) throw std::runtime_error("Sprite atlas already packed!");
+
+    SDL_Surface* bmp = SDL_LoadBMP(path.c_str());
+    if (!bmp) {
+        std::cerr << "Error: Failed to load " << path << ": " << SDL_GetError() << std::endl;
+        return -1;
+    }
+
+    int id = add(bmp, mode, key);
+    SDL_FreeSurface(bmp);
+    return id;
+}
+
+/**
+ * Keep an ARGB8888 copy of the surface until pack(): the atlas position is
+ * only known once every sprite is there
+ */
+int SpriteAtlas::add(SDL_Surface* surface, Sprite::BlitMode mode, const Color& key) {
+    if (is_packed()) throw std::runtime_error("Sprite atlas already packed!");
+    if (!surface) return -1;
+    if (surface->w > MAX_SIZE or surface->h > MAX_SIZE) {
+        std::cerr << "Error: Sprite larger than the atlas (" << surface->w << "x" << surface->h << ")" << std::endl;
+        return -1;
+    }
+
+    SDL_Surface* argb = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (!argb) {
+        std::cerr << "Error: Failed to convert the sprite: " << SDL_GetError() << std::endl;
+        return -1;
+    }
+
+    Sprite sprite;
+    sprite.m_rect = {0, 0, argb->w, argb->h};
+    sprite.m_mode = mode;
+    sprite.m_key = key.get_pixel_color() & RGB_MASK;
+    m_sprites.push_back(std::move(sprite));
+    m_sources.push_back(argb);
+    return static_cast<int>(m_sprites.size()) - 1;
+}
+
+/**
+ * Shelf packing on the narrowest power of two width that fits, then the
+ * pixels are copied into the atlas (alpha forced to opaque but for ALPHA
+ * sprites) and the spans are built from there
+ */
+bool SpriteAtlas::pack() {
+    if (is_packed()) return true;
+
+    std::vector<int> order(m_sprites.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        const SDL_Rect& ra = m_sprites[a].m_rect;
+        const SDL_Rect& rb = m_sprites[b].m_rect;
+        return ra.h != rb.h ? ra.h > rb.h : ra.w > rb.w;
+    });
+
+    uint64_t area = 0;
+    int widest = 1;
+    for (const Sprite& sprite : m_sprites) {
+        area += static_cast<uint64_t>(sprite.m_rect.w) * sprite.m_rect.h;
+        widest = std::max(widest, sprite.m_rect.w);
+    }
+
+    int atlas_width = 1;
+    while (atlas_width < widest or static_cast<uint64_t>(atlas_width) * atlas_width < area) atlas_width *= 2;
+
+    int atlas_height = 0;
+    while (atlas_width <= MAX_SIZE and !place(atlas_width, order, atlas_height)) atlas_width *= 2;
+    if (atlas_width > MAX_SIZE) {
+        std::cerr << "Error: The sprites do not fit in a " << MAX_SIZE << "x" << MAX_SIZE << " atlas" << std::endl;
+        return false;
+    }
+
+    m_atlas_ptr = SDL_CreateRGBSurfaceWithFormat(0, atlas_width, std::max(atlas_height, 1), 32,
+                                                 SDL_PIXELFORMAT_ARGB8888);
+    if (!m_atlas_ptr) {
+        std::cerr << "Error: Failed to create the sprite atlas: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    SDL_FillRect(m_atlas_ptr, nullptr, 0);
+
+    size_t atlas_pitch = m_atlas_ptr->pitch / sizeof(uint32_t);
+    for (size_t i = 0; i < m_sprites.size(); i++) {
+        Sprite& sprite = m_sprites[i];
+        SDL_Surface* source = m_sources[i];
+        uint32_t* atlas_pixels = static_cast<uint32_t*>(m_atlas_ptr->pixels) +
+                                 sprite.m_rect.y * atlas_pitch + sprite.m_rect.x;
+
+        if (SDL_MUSTLOCK(source)) SDL_LockSurface(source);
+        for (int row = 0; row < sprite.m_rect.h; row++) {
+            const uint32_t* from = reinterpret_cast<const uint32_t*>(
+                static_cast<const uint8_t*>(source->pixels) + row * source->pitch);
+            uint32_t* to = atlas_pixels + row * atlas_pitch;
+
+            if (sprite.m_mode == Sprite::BlitMode::ALPHA) {
+                std::copy_n(from, sprite.m_rect.w, to);
+            } else {
+                for (int x = 0; x < sprite.m_rect.w; x++) to[x] = from[x] | ALPHA_MASK;
+            }
+        }
+        if (SDL_MUSTLOCK(source)) SDL_UnlockSurface(source);
+        SDL_FreeSurface(source);
+
+        sprite.m_pixels = atlas_pixels;
+        sprite.m_pitch = atlas_pitch;
+        sprite.build_spans();
+    }
+    m_sources.clear();
+
+    return true;
+}
+
+// Destructor =============================================================== //
+SpriteAtlas::~SpriteAtlas() {
+    for (SDL_Surface* source : m_sources) SDL_FreeSurface(source);
+    if (m_atlas_ptr) SDL_FreeSurface(m_atlas_ptr);
+}
+
+// ========================================================================== //
+// Private interface                                                          //
+// ========================================================================== //
+
+// Instance methods ========================================================= //
+
+/**
+ * Fill shelves left to right: a sprite that does not fit on the current
+ * shelf opens a new one below, as tall as that sprite (the tallest left)
+ */
+bool SpriteAtlas::place(int atlas_width, const std::vector<int>& order, int& atlas_height) {
+    int x = 0, shelf_y = 0, shelf_height = 0;
+
+    for (int id : order) {
+        SDL_Rect& rect = m_sprites[id].m_rect;
+        if (rect.w > atlas_width) return false;
+
+        if (x + rect.w > atlas_width) {
+            shelf_y += shelf_height;
+            x = 0;
+            shelf_height = 0;
+        }
+        if (shelf_height == 0) shelf_height = rect.h;
+        if (shelf_y + rect.h > MAX_SIZE) return false;
+
+        rect.x = x;
+        rect.y = shelf_y;
+        x += rect.w;
+    }
+
+    atlas_height = shelf_y + shelf_height;
+    return true;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file SurfacePool.cpp
+ * @brief Recycles SDL surfaces of the same size and pixel format.
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#include "SurfacePool.h"
+
+// ========================================================================== //
+// Public interface                                                           //
+// ========================================================================== //
+
+// Class methods ============================================================ //
+
+/**
+ * Never destroyed: buffers with static storage may still release their
+ * surfaces during the program exit
+ */
+SurfacePool& SurfacePool::shared() {
+    static SurfacePool* pool = new SurfacePool();
+    return *pool;
+}
+
+// Constructors ============================================================= //
+
+SurfacePool::SurfacePool() : m_allocated(0), m_reused(0) {}
+
+// Instance methods ========================================================= //
+
+SDL_Surface* SurfacePool::acquire(int width, int height, uint32_t format) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto free = m_free.find(Key(width, height, format));
+        if (free != m_free.end() and !free->second.empty()) {
+            SDL_Surface* surface = free->second.back();
+            free->second.pop_back();
+            m_reused++;
+            return surface;
+        }
+        m_allocated++;
+    }
+
+    return SDL_CreateRGBSurfaceWithFormat(0, width, height, SDL_BITSPERPIXEL(format), format);
+}
+
+void SurfacePool::release(SDL_Surface* surface) {
+    if (!surface) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<SDL_Surface*>& free = m_free[Key(surface->w, surface->h, surface->format->format)];
+        if (free.size() < MAX_FREE_PER_KEY) {
+            free.push_back(surface);
+            return;
+        }
+    }
+
+    SDL_FreeSurface(surface);
+}
+
+void SurfacePool::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& [key, surfaces] : m_free) {
+        for (SDL_Surface* surface : surfaces) SDL_FreeSurface(surface);
+    }
+    m_free.clear();
+}
+
+SurfacePool::Stats SurfacePool::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t free = 0;
+    for (const auto& [key, surfaces] : m_free) free += surfaces.size();
+    return {m_allocated, m_reused, free};
+}
+
+// Destructor =============================================================== //
+
+SurfacePool::~SurfacePool() {
+    clear();
+}
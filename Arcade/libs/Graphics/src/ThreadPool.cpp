@@ -0,0 +1,103 @@
+/**
+ * @file ThreadPool.cpp
+ * @brief Fixed pool of worker threads running parallel-for loops.
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#include "ThreadPool.h"
+
+// ========================================================================== //
+// Public interface                                                           //
+// ========================================================================== //
+
+// Constructors ============================================================= //
+
+/**
+ * Spawn thread_count - 1 workers: the thread calling parallel_for() is the
+ * last one (thread index 0).
+ */
+ThreadPool::ThreadPool(unsigned thread_count)
+    : m_task(nullptr), m_count(0), m_next_index(0), m_busy_workers(0), m_generation(0), m_stop(false) {
+    for (unsigned i = 1; i < thread_count; i++) {
+        m_workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+// Instance methods ========================================================= //
+
+/**
+ * Run task(i) for every i in [0, count) and wait for all of them. Tasks can
+ * run in any order and on any thread, so they must not depend on each other.
+ */
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& task) {
+    parallel_for(count, [&task](size_t index, unsigned) { task(index); });
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t, unsigned)>& task) {
+    if (count == 0) return;
+
+    if (m_workers.empty() or count == 1) {
+        for (size_t i = 0; i < count; i++) task(i, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_count = count;
+        m_next_index.store(0, std::memory_order_relaxed);
+        m_busy_workers = static_cast<unsigned>(m_workers.size());
+        m_generation++;
+    }
+    m_start_cv.notify_all();
+
+    run_tasks(0);  // the caller works too
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done_cv.wait(lock, [this] { return m_busy_workers == 0; });
+    m_task = nullptr;
+}
+
+// Destructor =============================================================== //
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start_cv.notify_all();
+
+    for (std::thread& worker : m_workers) worker.join();
+}
+
+// ========================================================================== //
+// Private interface                                                          //
+// ========================================================================== //
+
+// Instance methods ========================================================= //
+
+void ThreadPool::worker_loop(unsigned thread_index) {
+    uint64_t seen_generation = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start_cv.wait(lock, [&] { return m_stop or m_generation != seen_generation; });
+            if (m_stop) return;
+            seen_generation = m_generation;
+        }
+
+        run_tasks(thread_index);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_busy_workers == 0) m_done_cv.notify_one();
+        }
+    }
+}
+
+void ThreadPool::run_tasks(unsigned thread_index) {
+    for (size_t i = m_next_index.fetch_add(1); i < m_count; i = m_next_index.fetch_add(1)) {
+        (*m_task)(i, thread_index);
+    }
+}
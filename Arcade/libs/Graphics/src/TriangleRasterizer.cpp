@@ -0,0 +1,173 @@
+/**
+ * @file TriangleRasterizer.cpp
+ * @brief Half-space (edge function) triangle filler working on 8x8 tiles.
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "TriangleRasterizer.h"
+
+namespace {
+
+// Floor and ceil of a / b for b > 0 (integer division truncates toward zero)
+inline int64_t floor_div(int64_t a, int64_t b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+inline int64_t ceil_div(int64_t a, int64_t b) { return -floor_div(-a, b); }
+
+}  // namespace
+
+// ========================================================================== //
+// Public interface                                                           //
+// ========================================================================== //
+
+// Instance methods ========================================================= //
+
+/**
+ * Prepare the edge functions and the tile grid of the triangle restricted to
+ * the clip rectangle. Returns false when there is nothing to fill (degenerate
+ * triangle or bounding box outside the clip rectangle).
+ */
+bool TriangleRasterizer::setup(const Vec2D& p0, const Vec2D& p1, const Vec2D& p2, const SDL_Rect& clip) {
+    const int64_t scale = int64_t(1) << SUBPIXEL_BITS;
+    const Vec2D* points[3] = {&p0, &p1, &p2};
+
+    // Snap the vertices to the sub-pixel grid
+    int64_t vx[3], vy[3];
+    for (int i = 0; i < 3; i++) {
+        vx[i] = std::llround(points[i]->get_x() * scale);
+        vy[i] = std::llround(points[i]->get_y() * scale);
+    }
+
+    // Make the winding consistent: positive area means every edge function is
+    // positive inside the triangle
+    int64_t area = (vx[1] - vx[0]) * (vy[2] - vy[0]) - (vy[1] - vy[0]) * (vx[2] - vx[0]);
+    if (area == 0) return false;
+    if (area < 0) {
+        std::swap(vx[1], vx[2]);
+        std::swap(vy[1], vy[2]);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        int j = (i + 1) % 3;
+        int64_t dx = vx[j] - vx[i];
+        int64_t dy = vy[j] - vy[i];
+
+        // E(p) = dx * (p.y - a.y) - dy * (p.x - a.x) with p sampled on the pixel grid
+        EdgeFunction& edge = m_edges[i];
+        edge.a = -dy * scale;
+        edge.b = dx * scale;
+        edge.c = dy * vx[i] - dx * vy[i];
+
+        // Top-left rule: pixels exactly on an edge belong to the triangle only
+        // for top (horizontal, inside below) and left (inside on the right) edges
+        bool top_left = dy < 0 or (dy == 0 and dx > 0);
+        if (!top_left) edge.c -= 1;
+    }
+
+    // Bounding box on the pixel grid, clipped
+    int64_t min_x = ceil_div(std::min({vx[0], vx[1], vx[2]}), scale);
+    int64_t min_y = ceil_div(std::min({vy[0], vy[1], vy[2]}), scale);
+    int64_t max_x = floor_div(std::max({vx[0], vx[1], vx[2]}), scale);
+    int64_t max_y = floor_div(std::max({vy[0], vy[1], vy[2]}), scale);
+
+    m_min_x = static_cast<int>(std::max<int64_t>(min_x, clip.x));
+    m_min_y = static_cast<int>(std::max<int64_t>(min_y, clip.y));
+    m_max_x = static_cast<int>(std::min<int64_t>(max_x, clip.x + clip.w - 1));
+    m_max_y = static_cast<int>(std::min<int64_t>(max_y, clip.y + clip.h - 1));
+    if (m_min_x > m_max_x or m_min_y > m_max_y) return false;
+
+    m_tiles_x = (m_max_x - m_min_x) / TILE_SIZE + 1;
+    m_tiles_y = (m_max_y - m_min_y) / TILE_SIZE + 1;
+
+    return true;
+}
+
+/**
+ * Fill the triangle prepared by setup(). Large triangles are spread over the
+ * pool one row of tiles per task.
+ */
+template <BlendMode M>
+void TriangleRasterizer::fill(ScreenBuffer& buffer, const Color& color, ThreadPool* pool) const {
+    int bbox_area = (m_max_x - m_min_x + 1) * (m_max_y - m_min_y + 1);
+
+    if (pool and pool->size() > 1 and bbox_area >= PARALLEL_MIN_AREA) {
+        pool->parallel_for(m_tiles_y, [&](size_t tile_row) {
+            fill_tile_row<M>(buffer, color, static_cast<int>(tile_row));
+        });
+    } else {
+        for (int tile_row = 0; tile_row < m_tiles_y; tile_row++) fill_tile_row<M>(buffer, color, tile_row);
+    }
+}
+
+// ========================================================================== //
+// Private interface                                                          //
+// ========================================================================== //
+
+// Instance methods ========================================================= //
+
+template <BlendMode M>
+void TriangleRasterizer::fill_tile_row(ScreenBuffer& buffer, const Color& color, int tile_row) const {
+    int y0 = m_min_y + tile_row * TILE_SIZE;
+    int y1 = std::min(y0 + TILE_SIZE - 1, m_max_y);
+
+    for (int x0 = m_min_x; x0 <= m_max_x; x0 += TILE_SIZE) {
+        fill_tile<M>(buffer, color, x0, y0, std::min(x0 + TILE_SIZE - 1, m_max_x), y1);
+    }
+}
+
+/**
+ * Edge functions are linear, so their extremes over a tile are on its corners:
+ * a tile is rejected when all its corners are outside one edge and accepted
+ * when all its corners are inside every edge.
+ */
+template <BlendMode M>
+void TriangleRasterizer::fill_tile(ScreenBuffer& buffer, const Color& color, int x0, int y0, int x1, int y1) const {
+    const uint32_t argb = color.get_pixel_color();
+    bool fully_inside = true;
+
+    for (const EdgeFunction& edge : m_edges) {
+        int64_t c00 = edge.at(x0, y0);
+        int64_t c10 = edge.at(x1, y0);
+        int64_t c01 = edge.at(x0, y1);
+        int64_t c11 = edge.at(x1, y1);
+
+        if (std::max({c00, c10, c01, c11}) < 0) return;  // trivial reject
+        if (std::min({c00, c10, c01, c11}) < 0) fully_inside = false;
+    }
+
+    if (fully_inside) {  // trivial accept
+        for (int y = y0; y <= y1; y++) buffer.write_span<M>(x0, x1, y, argb);
+        return;
+    }
+
+    // Partial tile: the inside pixels of a row are contiguous (convex shape)
+    for (int y = y0; y <= y1; y++) {
+        int64_t w0 = m_edges[0].at(x0, y);
+        int64_t w1 = m_edges[1].at(x0, y);
+        int64_t w2 = m_edges[2].at(x0, y);
+        int start = -1;
+        int end = -1;
+
+        for (int x = x0; x <= x1; x++) {
+            if ((w0 | w1 | w2) >= 0) {  // all the signs are positive
+                if (start < 0) start = x;
+                end = x;
+            } else if (start >= 0) {
+                break;
+            }
+            w0 += m_edges[0].a;
+            w1 += m_edges[1].a;
+            w2 += m_edges[2].a;
+        }
+
+        if (start >= 0) buffer.write_span<M>(start, end, y, argb);
+    }
+}
+
+// Explicit instantiations ================================================== //
+template void TriangleRasterizer::fill<BlendMode::OPAQUE>(ScreenBuffer&, const Color&, ThreadPool*) const;
+template void TriangleRasterizer::fill<BlendMode::SOURCE_OVER>(ScreenBuffer&, const Color&, ThreadPool*) const;
+template void TriangleRasterizer::fill<BlendMode::ADDITIVE>(ScreenBuffer&, const Color&, ThreadPool*) const;
+template void TriangleRasterizer::fill<BlendMode::MULTIPLY>(ScreenBuffer&, const Color&, ThreadPool*) const;
+template void TriangleRasterizer::fill<BlendMode::XOR>(ScreenBuffer&, const Color&, ThreadPool*) const;
@@ -1,15 +1,12 @@
 #include "graphics_utils.h"
 
-#include <iostream>
 #include <cmath>
 #include <algorithm>
 
 /**
- * 
+ * The error between the polygon and the circle stays under a pixel: the
+ * number of segments grows with the square root of the radius
  */
 unsigned int calculate_number_of_segments(float radius) {
-    unsigned number_of_segments = std::max(3u, static_cast<unsigned>(std::ceil(M_PI * std::sqrt(radius))));
-    std::cout << "number of segments: " << number_of_segments << std::endl;
-
-    return number_of_segments;
-}
\ No newline at end of file
+    return std::max(3u, static_cast<unsigned>(std::ceil(M_PI * std::sqrt(radius))));
+}
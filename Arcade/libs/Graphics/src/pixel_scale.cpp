@@ -0,0 +1,137 @@
+/**
+ * @file pixel_scale.cpp
+ * @brief Integer-factor nearest-neighbour magnification of 32 bit pixels.
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#include <cstring>
+#include "pixel_scale.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define PIXEL_SCALE_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using RowKernel = void (*)(const uint32_t*, uint32_t*, int, int);
+
+// Any factor: every pixel repeated factor times
+void widen_row(const uint32_t* src, uint32_t* dst, int count, int factor) {
+    for (int i = 0; i < count; i++) {
+        for (int k = 0; k < factor; k++) *dst++ = src[i];
+    }
+}
+
+void copy_row(const uint32_t* src, uint32_t* dst, int count, int) {
+    std::memcpy(dst, src, static_cast<size_t>(count) * sizeof(uint32_t));
+}
+
+#ifdef PIXEL_SCALE_X86
+
+// 4 source pixels at a time, factor full 128 bit stores
+inline __m128i load4(const uint32_t* src) {return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));}
+inline void store4(uint32_t* dst, __m128i v) {_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), v);}
+
+void widen_row_2(const uint32_t* src, uint32_t* dst, int count, int) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4, dst += 8) {
+        __m128i v = load4(src + i);
+        store4(dst, _mm_unpacklo_epi32(v, v));      // p0 p0 p1 p1
+        store4(dst + 4, _mm_unpackhi_epi32(v, v));  // p2 p2 p3 p3
+    }
+    widen_row(src + i, dst, count - i, 2);
+}
+
+void widen_row_3(const uint32_t* src, uint32_t* dst, int count, int) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4, dst += 12) {
+        __m128i v = load4(src + i);
+        store4(dst, _mm_shuffle_epi32(v, 0x40));      // p0 p0 p0 p1
+        store4(dst + 4, _mm_shuffle_epi32(v, 0xA5));  // p1 p1 p2 p2
+        store4(dst + 8, _mm_shuffle_epi32(v, 0xFE));  // p2 p3 p3 p3
+    }
+    widen_row(src + i, dst, count - i, 3);
+}
+
+void widen_row_4(const uint32_t* src, uint32_t* dst, int count, int) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4, dst += 16) {
+        __m128i v = load4(src + i);
+        store4(dst, _mm_shuffle_epi32(v, 0x00));
+        store4(dst + 4, _mm_shuffle_epi32(v, 0x55));
+        store4(dst + 8, _mm_shuffle_epi32(v, 0xAA));
+        store4(dst + 12, _mm_shuffle_epi32(v, 0xFF));
+    }
+    widen_row(src + i, dst, count - i, 4);
+}
+
+#endif  // PIXEL_SCALE_X86
+
+RowKernel row_kernel(int factor) {
+    switch (factor) {
+        case 1: return copy_row;
+#ifdef PIXEL_SCALE_X86
+        case 2: return widen_row_2;
+        case 3: return widen_row_3;
+        case 4: return widen_row_4;
+#endif
+        default: return widen_row;
+    }
+}
+
+// Copy the first destination row of a source row to the other factor - 1
+inline void replicate_row(uint32_t* dst_row, int dst_pitch, int w, int factor) {
+    const size_t row_bytes = static_cast<size_t>(w) * factor * sizeof(uint32_t);
+    for (int k = 1; k < factor; k++) {
+        std::memcpy(reinterpret_cast<uint8_t*>(dst_row) + k * dst_pitch, dst_row, row_bytes);
+    }
+}
+
+inline uint32_t* destination_row(void* dst, int dst_pitch, int x, int row, int factor) {
+    uint8_t* dst_bytes = static_cast<uint8_t*>(dst) + static_cast<size_t>(row) * factor * dst_pitch;
+    return reinterpret_cast<uint32_t*>(dst_bytes) + x * factor;
+}
+
+}  // namespace
+
+void scale_nearest(const void* src, int src_pitch, void* dst, int dst_pitch,
+                   int x, int y, int w, int h, int factor) {
+    if (w <= 0 or h <= 0 or factor <= 0) return;
+
+    RowKernel widen = row_kernel(factor);
+    for (int row = y; row < y + h; row++) {
+        const uint32_t* src_row = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(src) + row * src_pitch) + x;
+        uint32_t* dst_row = destination_row(dst, dst_pitch, x, row, factor);
+
+        widen(src_row, dst_row, w, factor);
+        replicate_row(dst_row, dst_pitch, w, factor);
+    }
+}
+
+/**
+ * The row is expanded into its last w destination pixels and widened from
+ * there (factor 1: expanded in place): every widened block is stored after
+ * its source pixels have been loaded and before the next ones, so no source
+ * pixel is overwritten before it is read.
+ */
+void scale_nearest_indexed(const void* src, int src_pitch, const uint32_t* palette, void* dst, int dst_pitch,
+                           int x, int y, int w, int h, int factor) {
+    if (w <= 0 or h <= 0 or factor <= 0) return;
+
+    RowKernel widen = row_kernel(factor);
+    for (int row = y; row < y + h; row++) {
+        const uint8_t* src_row = static_cast<const uint8_t*>(src) + row * src_pitch + x;
+        uint32_t* dst_row = destination_row(dst, dst_pitch, x, row, factor);
+
+        uint32_t* expanded = dst_row + static_cast<size_t>(w) * (factor - 1);
+        expand_indexed(src_row, palette, expanded, w);
+        if (factor > 1) widen(expanded, dst_row, w, factor);
+        replicate_row(dst_row, dst_pitch, w, factor);
+    }
+}
+
+void expand_indexed(const uint8_t* src, const uint32_t* palette, uint32_t* dst, int count) {
+    for (int i = 0; i < count; i++) dst[i] = palette[src[i]];
+}
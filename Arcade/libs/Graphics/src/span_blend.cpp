@@ -0,0 +1,225 @@
+/**
+ * @file span_blend.cpp
+ * @brief Alpha blending kernels for horizontal runs of ARGB8888 pixels.
+ *
+ * The SIMD kernels widen each 8 bit channel to a 16 bit lane, compute
+ * a * s + (255 - a) * d (at most 255 * 255, so it fits an unsigned 16 bit lane)
+ * and divide by 255 with (x + 1 + (x >> 8)) >> 8, which is exact over that
+ * range. The output is therefore bit-exact with Color::alpha_blending.
+ *
+ * @author SimoX
+ * @date 2026-10-17
+ */
+
+#include <algorithm>
+#include "Color.h"
+#include "span_blend.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define SPAN_BLEND_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr uint32_t OPAQUE_MASK = 0xFF000000;
+
+using SolidKernel = void (*)(uint32_t*, size_t, uint32_t);
+using PixelsKernel = void (*)(uint32_t*, const uint32_t*, size_t);
+
+// Opaque sources are copied, fully transparent ones only make the destination opaque
+inline void make_opaque(uint32_t* dst, size_t count) {
+    for (size_t i = 0; i < count; i++) dst[i] |= OPAQUE_MASK;
+}
+
+#ifdef SPAN_BLEND_X86
+
+// SSE2 ===================================================================== //
+
+inline __m128i div_255_epi16(__m128i x) {
+    const __m128i one = _mm_set1_epi16(1);
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, one), _mm_srli_epi16(x, 8)), 8);
+}
+
+void solid_sse2(uint32_t* dst, size_t count, uint32_t argb) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i opaque = _mm_set1_epi32(static_cast<int>(OPAQUE_MASK));
+    const uint32_t alpha = argb >> 24;
+
+    // source * alpha is the same for every pixel: compute it once
+    const __m128i src = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(argb)), zero);
+    const __m128i src_alpha = _mm_mullo_epi16(src, _mm_set1_epi16(static_cast<short>(alpha)));
+    const __m128i inv_alpha = _mm_set1_epi16(static_cast<short>(255 - alpha));
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i lo = _mm_add_epi16(src_alpha, _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv_alpha));
+        __m128i hi = _mm_add_epi16(src_alpha, _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv_alpha));
+
+        __m128i out = _mm_packus_epi16(div_255_epi16(lo), div_255_epi16(hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(out, opaque));
+    }
+    span_blend_solid_scalar(dst + i, count - i, argb);
+}
+
+inline __m128i blend_16_sse2(__m128i s, __m128i d) {
+    const __m128i max = _mm_set1_epi16(255);
+    // broadcast the alpha word of each pixel over its four channels
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, _mm_sub_epi16(max, a)));
+    return div_255_epi16(x);
+}
+
+void pixels_sse2(uint32_t* dst, const uint32_t* src, size_t count) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i opaque = _mm_set1_epi32(static_cast<int>(OPAQUE_MASK));
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+        // Fast path: four opaque sources are a plain copy
+        __m128i alpha = _mm_and_si128(s, opaque);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, opaque)) == 0xFFFF) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), s);
+            continue;
+        }
+
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i lo = blend_16_sse2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+        __m128i hi = blend_16_sse2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_packus_epi16(lo, hi), opaque));
+    }
+    span_blend_pixels_scalar(dst + i, src + i, count - i);
+}
+
+// AVX2 ===================================================================== //
+// unpack/pack/shuffle work inside each 128 bit lane, so the pixel order is
+// preserved exactly as in the SSE2 version.
+
+__attribute__((target("avx2")))
+inline __m256i div_255_epi16_avx2(__m256i x) {
+    const __m256i one = _mm256_set1_epi16(1);
+    return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(x, one), _mm256_srli_epi16(x, 8)), 8);
+}
+
+__attribute__((target("avx2")))
+void solid_avx2(uint32_t* dst, size_t count, uint32_t argb) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i opaque = _mm256_set1_epi32(static_cast<int>(OPAQUE_MASK));
+    const uint32_t alpha = argb >> 24;
+
+    const __m256i src = _mm256_unpacklo_epi8(_mm256_set1_epi32(static_cast<int>(argb)), zero);
+    const __m256i src_alpha = _mm256_mullo_epi16(src, _mm256_set1_epi16(static_cast<short>(alpha)));
+    const __m256i inv_alpha = _mm256_set1_epi16(static_cast<short>(255 - alpha));
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i lo = _mm256_add_epi16(src_alpha, _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), inv_alpha));
+        __m256i hi = _mm256_add_epi16(src_alpha, _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), inv_alpha));
+
+        __m256i out = _mm256_packus_epi16(div_255_epi16_avx2(lo), div_255_epi16_avx2(hi));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_or_si256(out, opaque));
+    }
+    solid_sse2(dst + i, count - i, argb);
+}
+
+__attribute__((target("avx2")))
+inline __m256i blend_16_avx2(__m256i s, __m256i d) {
+    const __m256i max = _mm256_set1_epi16(255);
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m256i x = _mm256_add_epi16(_mm256_mullo_epi16(s, a), _mm256_mullo_epi16(d, _mm256_sub_epi16(max, a)));
+    return div_255_epi16_avx2(x);
+}
+
+__attribute__((target("avx2")))
+void pixels_avx2(uint32_t* dst, const uint32_t* src, size_t count) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i opaque = _mm256_set1_epi32(static_cast<int>(OPAQUE_MASK));
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+
+        __m256i alpha = _mm256_and_si256(s, opaque);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, opaque)) == -1) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), s);
+            continue;
+        }
+
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i lo = blend_16_avx2(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero));
+        __m256i hi = blend_16_avx2(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_or_si256(_mm256_packus_epi16(lo, hi), opaque));
+    }
+    pixels_sse2(dst + i, src + i, count - i);
+}
+
+#endif  // SPAN_BLEND_X86
+
+// Runtime dispatch ========================================================= //
+
+struct Kernels {
+    SolidKernel solid;
+    PixelsKernel pixels;
+    const char* isa;
+};
+
+Kernels select_kernels() {
+#ifdef SPAN_BLEND_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return {solid_avx2, pixels_avx2, "AVX2"};
+    return {solid_sse2, pixels_sse2, "SSE2"};
+#else
+    return {span_blend_solid_scalar, span_blend_pixels_scalar, "scalar"};
+#endif
+}
+
+const Kernels& kernels() {
+    static const Kernels selected = select_kernels();
+    return selected;
+}
+
+}  // namespace
+
+/**
+ * Blend a constant color over a run of pixels. Opaque colors are a plain fill
+ * and fully transparent ones never touch the color channels.
+ */
+void span_blend_solid(uint32_t* dst, size_t count, uint32_t argb) {
+    const uint32_t alpha = argb >> 24;
+
+    if (alpha == 255) {
+        std::fill_n(dst, count, argb);
+    } else if (alpha == 0) {
+        make_opaque(dst, count);
+    } else {
+        kernels().solid(dst, count, argb);
+    }
+}
+
+/**
+ * Blend a run of source pixels over a run of destination pixels
+ */
+void span_blend_pixels(uint32_t* dst, const uint32_t* src, size_t count) {
+    kernels().pixels(dst, src, count);
+}
+
+void span_blend_solid_scalar(uint32_t* dst, size_t count, uint32_t argb) {
+    const Color source(argb);
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = Color::alpha_blending(source, Color(dst[i])).get_pixel_color();
+    }
+}
+
+void span_blend_pixels_scalar(uint32_t* dst, const uint32_t* src, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = Color::alpha_blending(Color(src[i]), Color(dst[i])).get_pixel_color();
+    }
+}
+
+const char* span_blend_isa() {
+    return kernels().isa;
+}
@@ -1 +1,1512 @@
-// TODO: create tests
\ No newline at end of file
+#include "gtest/gtest.h"
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "BitmapFont.h"
+#include "BlendMode.h"
+#include "Color.h"
+#include "DirtyRegion.h"
+#include "DrawList.h"
+#include "FrameRecorder.h"
+#include "PolygonFiller.h"
+#include "Rasterizer.h"
+#include "Screen.h"
+#include "ScreenBuffer.h"
+#include "Sprite.h"
+#include "SurfacePool.h"
+#include "ThreadPool.h"
+#include "TriangleRasterizer.h"
+#include "Palette.h"
+#include "pixel_scale.h"
+#include "span_blend.h"
+
+// Color tests ============================================================== //
+
+// Test channel getters on a packed ARGB value
+TEST(ColorTest, ChannelGetters) {
+    Color c(0x5500FFA0);
+    EXPECT_EQ(c.get_alpha(), 0x55);
+    EXPECT_EQ(c.get_red(), 0x00);
+    EXPECT_EQ(c.get_green(), 0xFF);
+    EXPECT_EQ(c.get_blue(), 0xA0);
+}
+
+// Test RGBA constructor and setters
+TEST(ColorTest, ChannelSetters) {
+    Color c(10, 20, 30, 40);
+    EXPECT_EQ(c.get_pixel_color(), 0x280A141Eu);
+
+    c.set_red(0xAA);
+    c.set_green(0xBB);
+    c.set_blue(0xCC);
+    c.set_alpha(0xDD);
+    EXPECT_EQ(c.get_pixel_color(), 0xDDAABBCCu);
+}
+
+// Test colors are usable in constant expressions
+TEST(ColorTest, Constexpr) {
+    constexpr Color orange = Color::Orange();
+    static_assert(orange.get_green() == 0xA5);
+    static_assert(Color::alpha_blending(Color::White(), Color::Black()) == Color::White());
+    EXPECT_EQ(orange.get_pixel_color(), Color::ORANGE);
+}
+
+// Test the exact integer division used by the blending
+TEST(ColorTest, Div255) {
+    for (uint32_t x = 0; x <= 255 * 255; x++) {
+        ASSERT_EQ(Color::div_255(x), x / 255);
+    }
+}
+
+// Test alpha blending against the reference equation
+TEST(ColorTest, AlphaBlending) {
+    Color destination(0xFF204060);
+    for (uint32_t alpha = 0; alpha <= 255; alpha++) {
+        Color source(10, 200, 255, static_cast<uint8_t>(alpha));
+        Color out = Color::alpha_blending(source, destination);
+
+        EXPECT_EQ(out.get_alpha(), 255);
+        EXPECT_EQ(out.get_red(), (10 * alpha + 0x20 * (255 - alpha)) / 255);
+        EXPECT_EQ(out.get_green(), (200 * alpha + 0x40 * (255 - alpha)) / 255);
+        EXPECT_EQ(out.get_blue(), (255 * alpha + 0x60 * (255 - alpha)) / 255);
+    }
+}
+
+// Span blending tests ====================================================== //
+
+// Test the dispatched solid kernel against the scalar reference for every
+// alpha and for lengths that exercise the vector body and the scalar tail
+TEST(SpanBlendTest, SolidMatchesScalar) {
+    std::mt19937 rng(42);
+    for (size_t count = 0; count <= 37; count++) {
+        for (uint32_t alpha = 0; alpha <= 255; alpha++) {
+            std::vector<uint32_t> dst(count);
+            for (auto& p : dst) p = rng();
+            std::vector<uint32_t> ref = dst;
+
+            uint32_t argb = (alpha << 24) | (rng() & 0x00FFFFFF);
+            span_blend_solid(dst.data(), count, argb);
+            span_blend_solid_scalar(ref.data(), count, argb);
+            ASSERT_EQ(dst, ref) << "count " << count << " alpha " << alpha << " isa " << span_blend_isa();
+        }
+    }
+}
+
+// Test the dispatched per-pixel kernel against the scalar reference, with
+// blocks of opaque sources mixed in to hit the copy fast path
+TEST(SpanBlendTest, PixelsMatchScalar) {
+    std::mt19937 rng(7);
+    for (size_t count = 0; count <= 67; count++) {
+        for (int round = 0; round < 64; round++) {
+            std::vector<uint32_t> src(count), dst(count);
+            for (size_t i = 0; i < count; i++) {
+                src[i] = rng();
+                if ((i / 8 + round) % 3 == 0) src[i] |= 0xFF000000;
+                dst[i] = rng();
+            }
+            std::vector<uint32_t> ref = dst;
+
+            span_blend_pixels(dst.data(), src.data(), count);
+            span_blend_pixels_scalar(ref.data(), src.data(), count);
+            ASSERT_EQ(dst, ref) << "count " << count << " isa " << span_blend_isa();
+        }
+    }
+}
+
+// Pixel scale tests ======================================================== //
+
+TEST(PixelScaleTest, MatchesNearestNeighbour) {
+    std::mt19937 rng(3);
+    const int width = 21, height = 7;
+    std::vector<uint32_t> src(width * height);
+    for (uint32_t& pixel : src) pixel = rng();
+
+    for (int factor = 1; factor <= 5; factor++) {
+        const int dst_width = width * factor + 3;  // padded pitch
+        std::vector<uint32_t> dst(dst_width * height * factor, 0xDEADBEEF);
+
+        // A sub-rectangle: everything outside it must stay untouched
+        const int x = 2, y = 1, w = 17, h = 5;
+        scale_nearest(src.data(), width * 4, dst.data(), dst_width * 4, x, y, w, h, factor);
+
+        for (int dy = 0; dy < height * factor; dy++) {
+            for (int dx = 0; dx < dst_width; dx++) {
+                int sx = dx / factor, sy = dy / factor;
+                bool inside = dx < width * factor and sx >= x and sx < x + w and sy >= y and sy < y + h;
+                uint32_t expected = inside ? src[sy * width + sx] : 0xDEADBEEF;
+                ASSERT_EQ(dst[dy * dst_width + dx], expected) << "factor " << factor << " at " << dx << ", " << dy;
+            }
+        }
+    }
+}
+
+TEST(PixelScaleTest, IndexedMatchesExpandedThenScaled) {
+    std::mt19937 rng(4);
+    const int width = 19, height = 6;
+    Palette palette;
+    std::vector<uint8_t> indices(width * height);
+    std::vector<uint32_t> expanded(width * height);
+    for (size_t i = 0; i < indices.size(); i++) {
+        indices[i] = rng() % palette.size();
+        expanded[i] = palette.color(indices[i]);
+    }
+
+    for (int factor = 1; factor <= 5; factor++) {
+        std::vector<uint32_t> expected(width * factor * height * factor), dst(expected.size());
+        scale_nearest(expanded.data(), width * 4, expected.data(), width * factor * 4, 1, 1, 17, 4, factor);
+        scale_nearest_indexed(indices.data(), width, palette.colors(), dst.data(), width * factor * 4, 1, 1, 17, 4, factor);
+        ASSERT_EQ(dst, expected) << "factor " << factor;
+    }
+}
+
+// Palette tests ============================================================ //
+
+TEST(PaletteTest, NearestAndBlend) {
+    Palette palette;
+    EXPECT_EQ(palette.size(), 11);
+    for (int i = 0; i < palette.size(); i++) EXPECT_EQ(palette.index_of(palette.color(i)), i);
+
+    uint8_t black = palette.index_of(Color::BLACK);
+    uint8_t red = palette.index_of(Color::RED);
+    uint8_t white = palette.index_of(Color::WHITE);
+    EXPECT_EQ(palette.index_of(0xFFF01010), red);     // nearest
+    EXPECT_EQ(palette.index_of(0x00FFFFFF), white);   // alpha ignored
+
+    EXPECT_EQ(palette.blend(0x00FF0000, black), black);  // transparent
+    EXPECT_EQ(palette.blend(Color::RED, black), red);    // opaque
+    EXPECT_EQ(palette.blend(0x80FFFFFF, black), palette.index_of(Color::GRAY));  // half white over black
+
+    EXPECT_THROW(Palette(std::vector<Color>()), std::invalid_argument);
+}
+
+// Screen buffer tests ====================================================== //
+
+// Test a move hands the surface over without copying any pixel
+TEST(ScreenBufferTest, MoveDoesNotCopy) {
+    ScreenBuffer buffer;
+    buffer.init(32, 16);
+    buffer.set_pixel(Color::Red(), 3, 4);
+    SDL_Surface* surface = buffer.get_surface();
+    uint64_t deep_copies = ScreenBuffer::deep_copies();
+
+    ScreenBuffer moved(std::move(buffer));
+    EXPECT_EQ(moved.get_surface(), surface);
+    EXPECT_EQ(buffer.get_surface(), nullptr);
+    EXPECT_EQ(buffer.width(), 0);
+
+    ScreenBuffer assigned;
+    assigned = std::move(moved);
+    EXPECT_EQ(assigned.get_surface(), surface);
+    EXPECT_EQ(moved.get_surface(), nullptr);
+    EXPECT_EQ(assigned.get_row(4)[3], Color::RED);
+    EXPECT_EQ(ScreenBuffer::deep_copies(), deep_copies);
+
+    ScreenBuffer copy(assigned);
+    EXPECT_NE(copy.get_surface(), surface);
+    EXPECT_EQ(copy.get_row(4)[3], Color::RED);
+    EXPECT_EQ(ScreenBuffer::deep_copies(), deep_copies + 1);
+}
+
+// Test buffers of the same size and format recycle their surfaces
+TEST(ScreenBufferTest, PoolReusesSurfaces) {
+    SurfacePool& pool = SurfacePool::shared();
+    SDL_Surface* surface;
+    {
+        ScreenBuffer buffer;
+        buffer.init(24, 8);
+        surface = buffer.get_surface();
+    }
+    SurfacePool::Stats before = pool.stats();
+
+    ScreenBuffer buffer;
+    buffer.init(24, 8);
+    EXPECT_EQ(buffer.get_surface(), surface);
+    EXPECT_EQ(pool.stats().reused, before.reused + 1);
+    EXPECT_EQ(pool.stats().allocated, before.allocated);
+
+    // A different format is a different key
+    ScreenBuffer indexed;
+    indexed.init_indexed(24, 8, std::make_shared<Palette>());
+    EXPECT_NE(indexed.get_surface(), surface);
+    EXPECT_EQ(pool.stats().allocated, before.allocated + 1);
+}
+
+// Polygon filler tests ===================================================== //
+
+using PixelSet = std::set<std::pair<int, int>>;  // (y, x)
+
+// Per-scanline reference: intersect every edge with every row and sort
+// (crossings within 1e-6 of an integer count as exactly on it)
+static PixelSet reference_fill(const std::vector<Vec2D>& points) {
+    PixelSet pixels;
+    float top = points[0].get_y(), bottom = top, left = points[0].get_x(), right = left;
+    for (const Vec2D& p : points) {
+        top = std::min(top, p.get_y());
+        bottom = std::max(bottom, p.get_y());
+        left = std::min(left, p.get_x());
+        right = std::max(right, p.get_x());
+    }
+
+    for (int y = top; y < bottom; y++) {
+        std::vector<double> nodes;
+        size_t j = points.size() - 1;
+        for (size_t i = 0; i < points.size(); i++) {
+            double yi = points[i].get_y(), yj = points[j].get_y();
+            if ((yi <= y and yj > y) or (yj <= y and yi > y)) {
+                nodes.push_back(points[i].get_x() + (y - yi) / (yj - yi) * (points[j].get_x() - points[i].get_x()));
+            }
+            j = i;
+        }
+        std::sort(nodes.begin(), nodes.end());
+        for (size_t k = 0; k + 1 < nodes.size(); k += 2) {
+            int x0 = std::max(static_cast<int>(std::ceil(nodes[k] - 1e-6)), static_cast<int>(left) + 1);
+            int x1 = std::min(static_cast<int>(std::floor(nodes[k + 1] + 1e-6)), static_cast<int>(right) - 1);
+            for (int x = x0; x <= x1; x++) pixels.insert({y, x});
+        }
+    }
+    return pixels;
+}
+
+static PixelSet filler_pixels(PolygonFiller& filler, const std::vector<Vec2D>& points, int clip_top=-1000, int clip_bottom=1000) {
+    PixelSet pixels;
+    for (const auto& span : filler.scan(points, clip_top, clip_bottom)) {
+        for (int x = span.x0; x <= span.x1; x++) EXPECT_TRUE(pixels.insert({span.y, x}).second);
+    }
+    return pixels;
+}
+
+// Test triangles, rectangles and a polygonized circle against the reference
+TEST(PolygonFillerTest, MatchesReference) {
+    PolygonFiller filler;
+    std::vector<std::vector<Vec2D>> polygons = {
+        {Vec2D(10, 10), Vec2D(5, 30), Vec2D(30, 30)},
+        {Vec2D(20, 200), Vec2D(200, 150), Vec2D(120, 280)},
+        {Vec2D(100, 100), Vec2D(150, 100), Vec2D(150, 123), Vec2D(100, 123)},
+        {Vec2D(0, 0), Vec2D(40, 10), Vec2D(10, 20), Vec2D(40, 40), Vec2D(0, 40)},  // concave
+    };
+    std::vector<Vec2D> circle;
+    for (int i = 0; i < 22; i++) {
+        float angle = 2.0f * static_cast<float>(M_PI) * i / 22.0f;
+        circle.push_back(Vec2D(100.0f + 49.0f * std::cos(angle), 70.0f + 49.0f * std::sin(angle)));
+    }
+    polygons.push_back(circle);
+
+    for (const auto& polygon : polygons) {
+        EXPECT_EQ(filler_pixels(filler, polygon), reference_fill(polygon));
+    }
+}
+
+// Test random concave polygons with integer vertices
+TEST(PolygonFillerTest, RandomPolygons) {
+    PolygonFiller filler;
+    std::mt19937 rng(3);
+    for (int round = 0; round < 200; round++) {
+        std::vector<Vec2D> polygon;
+        size_t count = 3 + rng() % 8;
+        for (size_t i = 0; i < count; i++) polygon.push_back(Vec2D(static_cast<int>(rng() % 120) - 10, static_cast<int>(rng() % 120) - 10));
+
+        ASSERT_EQ(filler_pixels(filler, polygon), reference_fill(polygon)) << "round " << round;
+    }
+}
+
+// Test that only the rows inside the clip range are produced
+TEST(PolygonFillerTest, VerticalClip) {
+    PolygonFiller filler;
+    std::vector<Vec2D> triangle = {Vec2D(20, -50), Vec2D(200, 150), Vec2D(-40, 280)};
+
+    PixelSet expected;
+    for (const auto& pixel : reference_fill(triangle)) {
+        if (pixel.first >= 0 and pixel.first <= 99) expected.insert(pixel);
+    }
+    EXPECT_EQ(filler_pixels(filler, triangle, 0, 99), expected);
+}
+
+// Triangle rasterizer tests ================================================ //
+
+// Count how many times each pixel of a 128x128 buffer is covered: every fill
+// adds 1 to the blue channel of an opaque black buffer
+static std::vector<int> coverage(const std::vector<Triangle2D>& triangles, ThreadPool* pool=nullptr) {
+    ScreenBuffer buffer;
+    buffer.init(128, 128);
+    buffer.begin_frame();
+
+    TriangleRasterizer rasterizer;
+    SDL_Rect clip = {0, 0, 128, 128};
+    for (const Triangle2D& triangle : triangles) {
+        if (!rasterizer.setup(triangle, clip)) continue;
+
+        ScreenBuffer layer(buffer);
+        layer.clear_surface(Color(0, 0, 0, 0));
+        layer.begin_frame();
+        rasterizer.fill(layer, Color(0, 0, 1, 255), pool);
+        for (int y = 0; y < 128; y++) {
+            for (int x = 0; x < 128; x++) buffer.get_row(y)[x] += layer.get_row(y)[x] & 0xFF;
+        }
+    }
+
+    std::vector<int> counts;
+    for (int y = 0; y < 128; y++) {
+        for (int x = 0; x < 128; x++) counts.push_back(buffer.get_row(y)[x] & 0xFF);
+    }
+    return counts;
+}
+
+// Test a fan of triangles around a shared vertex covers every pixel of the
+// square once: shared edges are owned by exactly one triangle (top-left rule)
+TEST(TriangleRasterizerTest, SharedEdgesCoveredOnce) {
+    Vec2D center(60.5f, 50.0f);
+    std::vector<Vec2D> corners = {Vec2D(10, 10), Vec2D(110, 10), Vec2D(110, 110), Vec2D(10, 110)};
+    std::vector<Triangle2D> fan;
+    for (size_t i = 0; i < corners.size(); i++) {
+        fan.push_back(Triangle2D(center, corners[i], corners[(i + 1) % corners.size()]));
+    }
+
+    std::vector<int> counts = coverage(fan);
+    for (int y = 0; y < 128; y++) {
+        for (int x = 0; x < 128; x++) {
+            bool inside_square = (x >= 10 and x < 110 and y >= 10 and y < 110);
+            ASSERT_EQ(counts[y * 128 + x], inside_square ? 1 : 0) << "pixel " << x << ", " << y;
+        }
+    }
+}
+
+// Test the tiled rasterizer against a per-pixel inside test
+TEST(TriangleRasterizerTest, MatchesPixelTest) {
+    std::mt19937 rng(11);
+    for (int round = 0; round < 100; round++) {
+        Vec2D p[3];
+        for (Vec2D& point : p) point = Vec2D((rng() % 1600) / 10.0f - 16.0f, (rng() % 1600) / 10.0f - 16.0f);
+        Triangle2D triangle(p[0], p[1], p[2]);
+
+        // Edge function sign test on the pixel grid (vertices snapped to 1/16)
+        auto snapped = [](float v) { return std::llround(v * 16.0f); };
+        std::vector<int> expected(128 * 128, 0);
+        int64_t x0 = snapped(p[0].get_x()), y0 = snapped(p[0].get_y());
+        int64_t x1 = snapped(p[1].get_x()), y1 = snapped(p[1].get_y());
+        int64_t x2 = snapped(p[2].get_x()), y2 = snapped(p[2].get_y());
+        int64_t area = (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0);
+        for (int y = 0; y < 128 and area != 0; y++) {
+            for (int x = 0; x < 128; x++) {
+                int64_t px = x * 16, py = y * 16;
+                int64_t e0 = (x1 - x0) * (py - y0) - (y1 - y0) * (px - x0);
+                int64_t e1 = (x2 - x1) * (py - y1) - (y2 - y1) * (px - x1);
+                int64_t e2 = (x0 - x2) * (py - y2) - (y0 - y2) * (px - x2);
+                if (area < 0) { e0 = -e0; e1 = -e1; e2 = -e2; }
+                if (e0 > 0 and e1 > 0 and e2 > 0) expected[y * 128 + x] = 1;  // strictly inside
+            }
+        }
+
+        std::vector<int> counts = coverage({triangle});
+        for (size_t i = 0; i < counts.size(); i++) {
+            if (expected[i]) ASSERT_EQ(counts[i], 1) << "round " << round << " pixel " << i;
+            else ASSERT_LE(counts[i], 1) << "round " << round << " pixel " << i;
+        }
+    }
+}
+
+// Test the parallel fill gives the same pixels as the single-threaded one
+TEST(TriangleRasterizerTest, ParallelMatchesSingleThreaded) {
+    ThreadPool pool(4);
+    std::vector<Triangle2D> triangles = {
+        Triangle2D(Vec2D(-20, 3), Vec2D(140, 60), Vec2D(30, 127)),
+        Triangle2D(Vec2D(5, 5), Vec2D(120, 9), Vec2D(64, 100)),
+    };
+    EXPECT_EQ(coverage(triangles, &pool), coverage(triangles));
+}
+
+// Dirty region tests ======================================================= //
+
+// Test rectangles are clipped and touching ones are merged
+TEST(DirtyRegionTest, ClipAndMerge) {
+    DirtyRegion region;
+    region.set_bounds(100, 100);
+
+    region.add(-10, -10, 9, 9);   // clipped to (0, 0) - (9, 9)
+    region.add(10, 0, 19, 9);     // touches the first one
+    region.add(50, 50, 59, 59);   // separate
+    region.add(200, 200, 300, 300);  // outside
+
+    ASSERT_EQ(region.rects().size(), 2u);
+    EXPECT_EQ(region.area(), 20u * 10u + 10u * 10u);
+}
+
+// Test too many rectangles collapse into their bounding box
+TEST(DirtyRegionTest, CollapseWhenFull) {
+    DirtyRegion region;
+    region.set_bounds(1000, 1000);
+
+    for (int i = 0; i <= static_cast<int>(DirtyRegion::MAX_RECTS); i++) region.add(i * 10, 0, i * 10, 0);
+
+    ASSERT_EQ(region.rects().size(), 1u);
+    EXPECT_EQ(region.rects()[0].w, static_cast<int>(DirtyRegion::MAX_RECTS) * 10 + 1);
+}
+
+
+// Draw list tests ========================================================== //
+
+// Test commands hidden by a later opaque rectangle are culled, translucent
+// ones never hide anything
+TEST(DrawListTest, OcclusionCulling) {
+    DrawList list;
+    list.set_bounds(128, 128);
+
+    list.add(DrawCommand::circle(Vec2D(40, 40), 10, Color::Red(), true, Color::Green()));      // hidden
+    list.add(DrawCommand::line(Vec2D(0, 0), Vec2D(127, 127), Color::Red()));                   // hidden
+    list.add(DrawCommand::rectangle(Vec2D(0, 0), Vec2D(127, 127), Color::Cyan(), true, Color::Orange()));
+    list.add(DrawCommand::point(10, 10, Color::White()));                                      // after the cover
+    list.add(DrawCommand::rectangle(Vec2D(0, 0), Vec2D(127, 127), Color::Cyan(), true, Color(0x80FF0000)));
+    list.add(DrawCommand::point(500, 500, Color::White()));                                    // off-screen
+
+    const std::vector<uint32_t>& replay = list.prepare();
+
+    EXPECT_EQ(replay, (std::vector<uint32_t>{2, 3, 4}));
+    EXPECT_EQ(list.stats().recorded, 6u);
+    EXPECT_EQ(list.stats().culled, 3u);
+}
+
+// Test a cover must fill the whole bin, and non integer corners never cover
+TEST(DrawListTest, PartialCoverKeepsCommands) {
+    DrawList list;
+    list.set_bounds(128, 128);
+
+    list.add(DrawCommand::point(5, 5, Color::White()));
+    list.add(DrawCommand::rectangle(Vec2D(1, 0), Vec2D(127, 127), Color::Cyan(), true, Color::Orange()));
+    list.add(DrawCommand::point(100, 100, Color::White()));
+    list.add(DrawCommand::rectangle(Vec2D(0, 0), Vec2D(127.5f, 127), Color::Cyan(), true, Color::Orange()));
+
+    EXPECT_EQ(list.prepare().size(), 4u);
+}
+
+// Test the commands past the cost budget are dropped
+TEST(DrawListTest, CostBudget) {
+    DrawList list;
+    list.set_bounds(128, 128);
+    list.set_cost_budget(25);
+
+    for (int i = 0; i < 4; i++) list.add(DrawCommand::line(Vec2D(0, i), Vec2D(9, i), Color::White()));  // 10 pixels each
+
+    EXPECT_EQ(list.prepare().size(), 2u);
+    EXPECT_EQ(list.stats().dropped, 2u);
+    EXPECT_EQ(list.stats().cost, 20u);
+
+    list.set_cost_budget(0);
+    EXPECT_EQ(list.prepare().size(), 4u);
+}
+
+// Test a cover dropped by the budget hides nothing: the commands under it are
+// replayed, in the list and in the bins
+TEST(DrawListTest, DroppedCoverKeepsCommands) {
+    DrawList list;
+    list.set_bounds(64, 64);
+    list.set_cost_budget(700);
+
+    list.add(DrawCommand::rectangle(Vec2D(0, 0), Vec2D(63, 9), Color::Red(), true, Color::Red()));  // 640 pixels
+    list.add(DrawCommand::rectangle(Vec2D(0, 0), Vec2D(63, 63), Color::Cyan(), true, Color::Orange()));  // dropped
+    list.add(DrawCommand::point(5, 5, Color::White()));  // dropped too, drawing order is kept
+
+    EXPECT_EQ(list.prepare(), (std::vector<uint32_t>{0}));
+    EXPECT_EQ(list.stats().culled, 0u);
+    EXPECT_EQ(list.stats().dropped, 2u);
+    list.build_bins();
+    EXPECT_EQ(std::vector<uint32_t>(list.bin_begin(0), list.bin_end(0)), (std::vector<uint32_t>{0}));
+    EXPECT_EQ(std::vector<uint32_t>(list.bin_begin(1), list.bin_end(1)), (std::vector<uint32_t>{0}));
+
+    // The same frame on a headless screen keeps the background
+    Screen screen;
+    screen.init_headless(64, 64);
+    screen.set_render_mode(Screen::RenderMode::DEFERRED);
+    screen.set_draw_budget(700);
+    screen.draw(Rectangle2D(Vec2D(0, 0), Vec2D(63, 9)), Color::Red(), true, Color::Red());
+    screen.draw(Rectangle2D(Vec2D(0, 0), Vec2D(63, 63)), Color::Cyan(), true, Color::Orange());
+    screen.swap_screens();
+    EXPECT_EQ(screen.frame().get_row(5)[5], Color::RED);
+    EXPECT_EQ(screen.frame().get_row(40)[5], Color::BLACK);
+}
+
+// Test the bins hold the commands touching them, in submission order, and
+// leave out the ones hidden by a later opaque rectangle
+TEST(DrawListTest, Bins) {
+    DrawList list;
+    list.set_bounds(64, 40);  // 2 x 2 bins, the bottom ones 8 pixels high
+
+    list.add(DrawCommand::line(Vec2D(0, 0), Vec2D(63, 0), Color::Red()));                        // bins 0, 1
+    list.add(DrawCommand::rectangle(Vec2D(32, 0), Vec2D(63, 31), Color::Cyan(), true, Color::Orange()));  // bin 1
+    list.add(DrawCommand::point(40, 35, Color::White()));                                          // bin 3
+    list.prepare();
+    list.build_bins();
+
+    ASSERT_EQ(list.bin_count(), 4u);
+    EXPECT_EQ(std::vector<uint32_t>(list.bin_begin(0), list.bin_end(0)), (std::vector<uint32_t>{0}));
+    EXPECT_EQ(std::vector<uint32_t>(list.bin_begin(1), list.bin_end(1)), (std::vector<uint32_t>{1}));
+    EXPECT_EQ(list.bin_begin(2), list.bin_end(2));
+    EXPECT_EQ(std::vector<uint32_t>(list.bin_begin(3), list.bin_end(3)), (std::vector<uint32_t>{2}));
+
+    SDL_Rect rect = list.bin_rect(3);
+    EXPECT_EQ(rect.x, 32);
+    EXPECT_EQ(rect.y, 32);
+    EXPECT_EQ(rect.w, 32);
+    EXPECT_EQ(rect.h, 8);
+}
+
+// Rasterizer tests ========================================================= //
+
+// Test drawing tile by tile (any order of the tiles) gives exactly the pixels
+// of drawing on the whole buffer, translucent colors included
+TEST(RasterizerTest, TilesMatchWholeBuffer) {
+    std::mt19937 rng(11);
+    auto coord = [&rng]() { return static_cast<int>(rng() % 1600) / 10.0f - 15.0f; };
+
+    std::vector<DrawCommand> commands;
+    for (int i = 0; i < 200; i++) {
+        Color color(static_cast<uint32_t>(rng()));
+        Color fill_color(static_cast<uint32_t>(rng()));
+        Vec2D p0(coord(), coord()), p1(coord(), coord()), p2(coord(), coord());
+        switch (i % 5) {
+            case 0: commands.push_back(DrawCommand::point(rng() % 130, rng() % 130, color)); break;
+            case 1: commands.push_back(DrawCommand::line(p0, p1, color)); break;
+            case 2: commands.push_back(DrawCommand::triangle(p0, p1, p2, color, true, fill_color)); break;
+            case 3: commands.push_back(DrawCommand::rectangle(p0, p1, color, true, fill_color)); break;
+            case 4: commands.push_back(DrawCommand::circle(p0, rng() % 50, color, true, fill_color)); break;
+        }
+        if (i % 10 >= 5) commands.back().set_antialiased();
+    }
+
+    ScreenBuffer whole, tiled;
+    whole.init(128, 128);
+    tiled.init(128, 128);
+    whole.begin_frame();
+    tiled.begin_frame();
+
+    Rasterizer rasterizer;
+    SDL_Rect full = {0, 0, 128, 128};
+    for (const DrawCommand& command : commands) rasterizer.draw(whole, command, full);
+
+    for (int ty = 96; ty >= 0; ty -= 32) {
+        for (int tx = 0; tx < 128; tx += 32) {
+            SDL_Rect tile = {tx, ty, 32, 32};
+            for (const DrawCommand& command : commands) rasterizer.draw(tiled, command, tile);
+        }
+    }
+
+    for (int y = 0; y < 128; y++) {
+        ASSERT_TRUE(std::equal(whole.get_row(y), whole.get_row(y) + 128, tiled.get_row(y))) << "row " << y;
+    }
+}
+
+TEST(RasterizerTest, AntialiasedOutlinesStayInBoundingBox) {
+    std::mt19937 rng(5);
+    auto coord = [&rng]() { return static_cast<int>(rng() % 1000) / 10.0f + 10.0f; };
+
+    Rasterizer rasterizer;
+    SDL_Rect full = {0, 0, 128, 128};
+    for (int i = 0; i < 100; i++) {
+        Vec2D p0(coord(), coord()), p1(coord(), coord()), p2(coord(), coord());
+        DrawCommand command;
+        switch (i % 3) {
+            case 0: command = DrawCommand::line(p0, p1, Color::White()); break;
+            case 1: command = DrawCommand::triangle(p0, p1, p2, Color::White(), false, Color::White()); break;
+            case 2: command = DrawCommand::circle(p0, rng() % 10, Color::White(), false, Color::White()); break;
+        }
+        command.set_antialiased();
+
+        ScreenBuffer buffer;
+        buffer.init(128, 128);
+        buffer.begin_frame();
+        rasterizer.draw(buffer, command, full);
+        for (int y = 0; y < 128; y++) {
+            for (int x = 0; x < 128; x++) {
+                if (buffer.get_row(y)[x] & 0x00FFFFFF) {
+                    ASSERT_TRUE(x >= command.x0 and x <= command.x1 and y >= command.y0 and y <= command.y1)
+                        << "command " << i << " pixel " << x << ", " << y;
+                }
+            }
+        }
+    }
+}
+
+TEST(RasterizerTest, AntialiasedLineCoverage) {
+    ScreenBuffer buffer;
+    buffer.init(32, 32);
+    buffer.begin_frame();
+
+    // On a pixel row: a single row at full intensity
+    DrawCommand on_row = DrawCommand::line(Vec2D(2, 4), Vec2D(20, 4), Color::White());
+    on_row.set_antialiased();
+    Rasterizer rasterizer;
+    SDL_Rect full = {0, 0, 32, 32};
+    rasterizer.draw(buffer, on_row, full);
+    EXPECT_EQ(buffer.get_row(4)[10] & 0x00FFFFFF, 0x00FFFFFFu);
+    EXPECT_EQ(buffer.get_row(5)[10] & 0x00FFFFFF, 0u);
+
+    // Half way between two rows: both at half intensity
+    DrawCommand between = DrawCommand::line(Vec2D(2, 10.5f), Vec2D(20, 10.5f), Color::White());
+    between.set_antialiased();
+    rasterizer.draw(buffer, between, full);
+    uint32_t upper = buffer.get_row(10)[10] & 0xFF;
+    uint32_t lower = buffer.get_row(11)[10] & 0xFF;
+    EXPECT_NEAR(upper, 128, 2);
+    EXPECT_NEAR(lower, 128, 2);
+}
+
+// Pixels of the line drawn with the plain Bresenham walk, keeping the ones
+// inside a width x height buffer
+static std::set<std::pair<int, int>> bresenham_pixels(int x0, int y0, int x1, int y1, int width, int height) {
+    std::set<std::pair<int, int>> pixels;
+    auto plot = [&](int x, int y) {
+        if (x >= 0 and y >= 0 and x < width and y < height) pixels.insert({x, y});
+    };
+
+    int dx = x1 - x0, dy = y1 - y0;
+    int ix = (dx > 0) - (dx < 0), iy = (dy > 0) - (dy < 0);
+    dx = std::abs(dx) * 2;
+    dy = std::abs(dy) * 2;
+
+    plot(x0, y0);
+    if (dx >= dy) {
+        for (int d = dy - dx / 2; x0 != x1; d += dy) {
+            if (d >= 0) { d -= dx; y0 += iy; }
+            x0 += ix;
+            plot(x0, y0);
+        }
+    } else {
+        for (int d = dx - dy / 2; y0 != y1; d += dx) {
+            if (d >= 0) { d -= dy; x0 += ix; }
+            y0 += iy;
+            plot(x0, y0);
+        }
+    }
+    return pixels;
+}
+
+// Test lines clipped before the walk keep exactly the pixels of the full walk
+TEST(RasterizerTest, ClippedLinesMatchBresenham) {
+    ScreenBuffer buffer;
+    buffer.init(64, 48);
+    buffer.begin_frame();
+
+    Rasterizer rasterizer;
+    SDL_Rect clip = {0, 0, 64, 48};
+    std::mt19937 rng(5);
+
+    for (int i = 0; i < 2000; i++) {
+        int x0 = static_cast<int>(rng() % 200) - 70, y0 = static_cast<int>(rng() % 200) - 70;
+        int x1 = static_cast<int>(rng() % 200) - 70, y1 = static_cast<int>(rng() % 200) - 70;
+        if (i % 4 == 0) y1 = y0;  // horizontal
+        if (i % 4 == 1) x1 = x0;  // vertical
+
+        buffer.clear_surface(Color::Black());
+        rasterizer.draw(buffer, DrawCommand::line(Vec2D(x0, y0), Vec2D(x1, y1), Color::White()), clip);
+
+        std::set<std::pair<int, int>> drawn;
+        for (int y = 0; y < 48; y++) {
+            for (int x = 0; x < 64; x++) {
+                if (buffer.get_row(y)[x] == Color::WHITE) drawn.insert({x, y});
+            }
+        }
+        ASSERT_EQ(drawn, bresenham_pixels(x0, y0, x1, y1, 64, 48)) << x0 << "," << y0 << " - " << x1 << "," << y1;
+    }
+}
+
+// Test translucent integer rectangles blend every pixel once (outline on the
+// border, fill inside), drawn whole or tile by tile
+TEST(RasterizerTest, RectangleBlendsEveryPixelOnce) {
+    const Color outline(0x80FF0000), fill(0x4000FF00);
+    const uint32_t outline_pixel = Color::alpha_blending(outline, Color::Black()).get_pixel_color();
+    const uint32_t fill_pixel = Color::alpha_blending(fill, Color::Black()).get_pixel_color();
+    const int rects[][4] = {{5, 4, 20, 15}, {-3, 20, 70, 40}, {30, 2, 30, 12}, {8, 30, 16, 30}, {40, 8, 41, 9}};
+
+    ScreenBuffer whole, tiled;
+    whole.init(64, 48);
+    tiled.init(64, 48);
+    whole.begin_frame();
+    tiled.begin_frame();
+    Rasterizer rasterizer;
+
+    for (const auto& r : rects) {
+        whole.clear_surface(Color::Black());
+        tiled.clear_surface(Color::Black());
+        DrawCommand command = DrawCommand::rectangle(Vec2D(r[2], r[3]), Vec2D(r[0], r[1]), outline, true, fill);
+        rasterizer.draw(whole, command, {0, 0, 64, 48});
+        for (int ty = 0; ty < 48; ty += 8) {
+            for (int tx = 0; tx < 64; tx += 8) rasterizer.draw(tiled, command, {tx, ty, 8, 8});
+        }
+
+        for (int y = 0; y < 48; y++) {
+            for (int x = 0; x < 64; x++) {
+                bool inside = x >= r[0] and x <= r[2] and y >= r[1] and y <= r[3];
+                bool border = inside and (x == r[0] or x == r[2] or y == r[1] or y == r[3]);
+                uint32_t expected = border ? outline_pixel : inside ? fill_pixel : Color::BLACK;
+                ASSERT_EQ(whole.get_row(y)[x], expected) << x << "," << y << " in " << r[0] << "," << r[1];
+                ASSERT_EQ(tiled.get_row(y)[x], expected) << x << "," << y << " in " << r[0] << "," << r[1];
+            }
+        }
+    }
+}
+
+// Reference midpoint circle outline around (0, 0): one octant mirrored 8 ways
+static std::set<std::pair<int, int>> midpoint_outline(int radius) {
+    std::set<std::pair<int, int>> outline;
+    int x = radius, y = 0, d = 1 - radius;
+    while (y <= x) {
+        for (int sx : {-1, 1}) {
+            for (int sy : {-1, 1}) {
+                outline.insert({sx * x, sy * y});
+                outline.insert({sx * y, sy * x});
+            }
+        }
+        y++;
+        if (d < 0) {
+            d += 2 * y + 1;
+        } else {
+            x--;
+            d += 2 * (y - x) + 1;
+        }
+    }
+    return outline;
+}
+
+// Reference fill: on every row, the pixels strictly between the outline ones
+static std::set<std::pair<int, int>> midpoint_fill(const std::set<std::pair<int, int>>& outline) {
+    std::map<int, int> half_width;  // row -> smallest |x| of the outline
+    for (const auto& [x, y] : outline) {
+        auto row = half_width.find(y);
+        if (row == half_width.end() or std::abs(x) < row->second) half_width[y] = std::abs(x);
+    }
+    std::set<std::pair<int, int>> fill;
+    for (const auto& [y, width] : half_width) {
+        for (int x = -width + 1; x < width; x++) fill.insert({x, y});
+    }
+    return fill;
+}
+
+// Test midpoint circles against the reference pixels for small, odd, even and
+// clipped radii: the fill never touches the outline, and with translucent
+// colors every pixel is blended exactly once
+TEST(RasterizerTest, MidpointCircleMatchesReference) {
+    const Color outline_color(0x80FF0000), fill_color(0x8000FF00);
+    const uint32_t outline_pixel = Color::alpha_blending(outline_color, Color::Black()).get_pixel_color();
+    const uint32_t fill_pixel = Color::alpha_blending(fill_color, Color::Black()).get_pixel_color();
+    const int circles[][3] = {{20, 20, 0}, {20, 20, 1}, {20, 20, 2}, {30, 24, 7}, {30, 24, 10},
+                              {2, 3, 9}, {60, 45, 12}, {32, 24, 40}};  // cx, cy, radius
+
+    ScreenBuffer buffer;
+    buffer.init(64, 48);
+    buffer.begin_frame();
+    Rasterizer rasterizer;
+    const SDL_Rect whole = {0, 0, 64, 48};
+
+    auto drawn = [&buffer]() {
+        std::set<std::pair<int, int>> pixels;
+        for (int y = 0; y < 48; y++) {
+            for (int x = 0; x < 64; x++) {
+                if (buffer.get_row(y)[x] != Color::BLACK) pixels.insert({x, y});
+            }
+        }
+        return pixels;
+    };
+
+    for (const auto& c : circles) {
+        std::set<std::pair<int, int>> outline, fill;
+        for (const auto& [x, y] : midpoint_outline(c[2])) {
+            if (buffer.contains(c[0] + x, c[1] + y)) outline.insert({c[0] + x, c[1] + y});
+        }
+        for (const auto& [x, y] : midpoint_fill(midpoint_outline(c[2]))) {
+            if (buffer.contains(c[0] + x, c[1] + y)) fill.insert({c[0] + x, c[1] + y});
+        }
+
+        // Outline and fill drawn alone (fully transparent outline)
+        buffer.clear_surface(Color::Black());
+        rasterizer.draw(buffer, DrawCommand::circle(Vec2D(c[0], c[1]), c[2], Color::Red(), false, Color::White()), whole);
+        std::set<std::pair<int, int>> drawn_outline = drawn();
+        buffer.clear_surface(Color::Black());
+        rasterizer.draw(buffer, DrawCommand::circle(Vec2D(c[0], c[1]), c[2], Color(0), true, Color::Green()), whole);
+        std::set<std::pair<int, int>> drawn_fill = drawn();
+
+        EXPECT_EQ(drawn_outline, outline) << "radius " << c[2];
+        EXPECT_EQ(drawn_fill, fill) << "radius " << c[2];
+        for (const auto& pixel : drawn_fill) EXPECT_EQ(drawn_outline.count(pixel), 0u) << "radius " << c[2];
+
+        buffer.clear_surface(Color::Black());
+        rasterizer.draw(buffer, DrawCommand::circle(Vec2D(c[0], c[1]), c[2], outline_color, true, fill_color), whole);
+        for (int y = 0; y < 48; y++) {
+            for (int x = 0; x < 64; x++) {
+                uint32_t expected = outline.count({x, y}) ? outline_pixel : fill.count({x, y}) ? fill_pixel : Color::BLACK;
+                ASSERT_EQ(buffer.get_row(y)[x], expected) << x << "," << y << " radius " << c[2];
+            }
+        }
+    }
+}
+
+// Sprite tests ============================================================= //
+
+// A w x h ARGB8888 surface: every pixel an opaque color unique to the seed,
+// or the magenta key, or a translucent alpha level
+static SDL_Surface* sprite_surface(int w, int h, uint32_t seed) {
+    static const uint32_t ALPHAS[] = {0x00, 0x40, 0x80, 0xC8, 0xFF};
+
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+    for (int y = 0; y < h; y++) {
+        uint32_t* row = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(surface->pixels) + y * surface->pitch);
+        for (int x = 0; x < w; x++) {
+            uint32_t rgb = (seed * 0x3F1F + x * 0x1D07 + y * 0x0B51) & 0x00FFFFFF;
+            if ((x + 2 * y) % 5 == 0) rgb = Color::MAGENTA & 0x00FFFFFF;
+            row[x] = (ALPHAS[(x * 3 + y) % 5] << Color::ALPHA_SHIFT) | rgb;
+        }
+    }
+    return surface;
+}
+
+// Test the packed sprites never overlap and keep their pixels
+TEST(SpriteTest, AtlasPacking) {
+    std::mt19937 rng(21);
+    std::uniform_int_distribution<int> size(1, 40);
+
+    SpriteAtlas atlas;
+    std::vector<SDL_Surface*> sources;
+    for (uint32_t i = 0; i < 30; i++) {
+        sources.push_back(sprite_surface(size(rng), size(rng), i));
+        EXPECT_EQ(atlas.add(sources.back(), Sprite::BlitMode::OPAQUE), static_cast<int>(i));
+    }
+    EXPECT_EQ(atlas.add(nullptr, Sprite::BlitMode::OPAQUE), -1);
+    ASSERT_TRUE(atlas.pack());
+    EXPECT_THROW(atlas.add(sources[0], Sprite::BlitMode::OPAQUE), std::runtime_error);
+
+    const SDL_Surface* surface = atlas.get_surface();
+    for (size_t i = 0; i < atlas.size(); i++) {
+        const SDL_Rect& rect = atlas[i].atlas_rect();
+        EXPECT_EQ(rect.w, sources[i]->w);
+        EXPECT_EQ(rect.h, sources[i]->h);
+        EXPECT_TRUE(rect.x >= 0 and rect.y >= 0 and rect.x + rect.w <= surface->w and rect.y + rect.h <= surface->h);
+        for (size_t j = 0; j < i; j++) {
+            SDL_Rect other = atlas[j].atlas_rect();
+            EXPECT_FALSE(SDL_HasIntersection(&rect, &other)) << i << " overlaps " << j;
+        }
+
+        // Opaque: one span per row, alpha forced
+        EXPECT_EQ(atlas[i].visible_pixels(), static_cast<uint64_t>(rect.w) * rect.h);
+        for (int y = 0; y < rect.h; y++) {
+            const uint32_t* source = reinterpret_cast<const uint32_t*>(
+                static_cast<const uint8_t*>(sources[i]->pixels) + y * sources[i]->pitch);
+            ASSERT_EQ(atlas[i].spans_end(y) - atlas[i].spans_begin(y), 1);
+            for (int x = 0; x < rect.w; x++) ASSERT_EQ(atlas[i].row_pixels(y)[x], source[x] | 0xFF000000);
+        }
+    }
+    for (SDL_Surface* source : sources) SDL_FreeSurface(source);
+}
+
+// Test a sprite cannot be drawn before its atlas is packed
+TEST(SpriteTest, DrawRequiresPackedAtlas) {
+    Screen screen;
+    screen.init_headless(32, 32);
+    SDL_Surface* source = sprite_surface(8, 8, 1);
+    SpriteAtlas atlas;
+    int id = atlas.add(source, Sprite::BlitMode::OPAQUE);
+    SDL_FreeSurface(source);
+
+    EXPECT_FALSE(atlas[id].is_packed());
+    EXPECT_THROW(screen.draw(atlas[id], 4, 4), std::runtime_error);
+    ASSERT_TRUE(atlas.pack());
+    EXPECT_TRUE(atlas[id].is_packed());
+    EXPECT_NO_THROW(screen.draw(atlas[id], 4, 4));
+    screen.swap_screens();
+}
+
+// Test every blit mode, partially clipped, against a per-pixel reference and
+// in every render mode
+TEST(SpriteTest, BlitModesMatchReference) {
+    const Color background = Color::Black();
+    SDL_Surface* source = sprite_surface(23, 17, 7);
+
+    SpriteAtlas atlas;
+    int ids[3];
+    ids[0] = atlas.add(source, Sprite::BlitMode::OPAQUE);
+    ids[1] = atlas.add(source, Sprite::BlitMode::COLOR_KEY);
+    ids[2] = atlas.add(source, Sprite::BlitMode::ALPHA);
+    ASSERT_TRUE(atlas.pack());
+    EXPECT_FALSE(atlas[ids[1]].has_blending());
+    EXPECT_TRUE(atlas[ids[2]].has_blending());
+
+    const int positions[][2] = {{5, 4}, {-6, 40}, {50, -9}};
+    std::vector<uint32_t> expected(64 * 48, background.get_pixel_color());
+    for (int i = 0; i < 3; i++) {
+        for (int y = 0; y < source->h; y++) {
+            const uint32_t* row = reinterpret_cast<const uint32_t*>(
+                static_cast<const uint8_t*>(source->pixels) + y * source->pitch);
+            for (int x = 0; x < source->w; x++) {
+                int px = positions[i][0] + x, py = positions[i][1] + y;
+                if (px < 0 or py < 0 or px >= 64 or py >= 48) continue;
+
+                uint32_t& pixel = expected[py * 64 + px];
+                uint32_t alpha = row[x] >> Color::ALPHA_SHIFT;
+                if (i == 0) {
+                    pixel = row[x] | 0xFF000000;
+                } else if (i == 1) {
+                    if ((row[x] & 0x00FFFFFF) != (Color::MAGENTA & 0x00FFFFFF)) pixel = row[x] | 0xFF000000;
+                } else if (alpha == 255) {
+                    pixel = row[x];
+                } else if (alpha > 0) {
+                    pixel = Color::alpha_blending(Color(row[x]), Color(pixel)).get_pixel_color();
+                }
+            }
+        }
+    }
+
+    for (Screen::RenderMode mode : {Screen::RenderMode::IMMEDIATE, Screen::RenderMode::DEFERRED,
+                                    Screen::RenderMode::TILED}) {
+        Screen screen;
+        screen.init_headless(64, 48);
+        screen.set_raster_threads(3);
+        screen.set_render_mode(mode);
+
+        for (int i = 0; i < 3; i++) screen.draw(atlas[ids[i]], positions[i][0], positions[i][1]);
+        screen.swap_screens();
+
+        const ScreenBuffer& frame = screen.frame();
+        for (int y = 0; y < 48; y++) {
+            for (int x = 0; x < 64; x++) {
+                ASSERT_EQ(frame.get_row(y)[x], expected[y * 64 + x]) << x << "," << y << " mode " << static_cast<int>(mode);
+            }
+        }
+    }
+    SDL_FreeSurface(source);
+}
+
+// Bitmap font tests ======================================================== //
+
+// Ink pixels of a laid out text, relative to its top-left corner
+static std::set<std::pair<int, int>> text_pixels(const TextRun& run) {
+    std::set<std::pair<int, int>> pixels;
+    for (int row = 0; row < run.height; row++) {
+        for (const TextRun::Span* span = run.spans_begin(row); span != run.spans_end(row); span++) {
+            for (int x = span->x; x < span->x + span->length; x++) pixels.insert({x, row});
+        }
+    }
+    return pixels;
+}
+
+// Test the glyph masks, the fixed and proportional advances, span merging and the cache
+TEST(BitmapFontTest, Layout) {
+    BitmapFont fixed;
+    std::shared_ptr<const TextRun> i = fixed.layout("I");
+    EXPECT_EQ(i->width, 5);
+    EXPECT_EQ(i->height, 7);
+    EXPECT_EQ(i->pixels, 11u);
+    std::set<std::pair<int, int>> expected = {{1, 0}, {2, 0}, {3, 0}, {1, 6}, {2, 6}, {3, 6}};
+    for (int row = 1; row < 6; row++) expected.insert({2, row});
+    EXPECT_EQ(text_pixels(*i), expected);
+
+    EXPECT_EQ(fixed.layout("II")->width, 11);
+    EXPECT_EQ(fixed.layout("A\nB")->height, 15);
+    EXPECT_EQ(text_pixels(*fixed.layout("\x01")), text_pixels(*fixed.layout("?"))) << "unknown characters are '?'";
+    EXPECT_EQ(fixed.layout("I"), i);
+    EXPECT_EQ(fixed.cached_texts(), 5u);
+
+    BitmapFont proportional(BitmapFont::Spacing::PROPORTIONAL);
+    EXPECT_EQ(proportional.advance('I'), 4);
+    EXPECT_EQ(proportional.advance('W'), 6);
+    EXPECT_EQ(proportional.layout("II")->width, 7);
+    EXPECT_EQ(text_pixels(*proportional.layout("I")).count({0, 0}), 1u);
+
+    // Touching glyph runs are merged into one span
+    fixed.set_letter_spacing(0);
+    EXPECT_EQ(fixed.cached_texts(), 0u);
+    std::shared_ptr<const TextRun> dashes = fixed.layout("--");
+    ASSERT_EQ(dashes->spans.size(), 1u);
+    EXPECT_EQ(dashes->spans[0].x, 0);
+    EXPECT_EQ(dashes->spans[0].length, 10);
+}
+
+// Test glyphs overlapping with a negative spacing still give disjoint spans,
+// so a translucent text blends every pixel once
+TEST(BitmapFontTest, NegativeSpacingMergesOverlaps) {
+    BitmapFont font;
+    font.set_letter_spacing(-3);
+    font.set_line_spacing(-20);
+    EXPECT_EQ(font.advance('H'), 2);
+    EXPECT_EQ(font.advance('I'), 2);
+    std::shared_ptr<const TextRun> run = font.layout("HHHH\nWW");
+    EXPECT_EQ(run->height, font.cell_height());  // the lines overlap too
+
+    uint64_t pixels = 0;
+    for (int row = 0; row < run->height; row++) {
+        for (const TextRun::Span* span = run->spans_begin(row); span != run->spans_end(row); span++) {
+            EXPECT_GT(span->length, 0);
+            if (span + 1 != run->spans_end(row)) {
+                EXPECT_GT(span[1].x, span->x + span->length) << "row " << row;
+            }
+            pixels += span->length;
+        }
+    }
+    EXPECT_EQ(run->pixels, pixels);
+    EXPECT_EQ(text_pixels(*run).size(), pixels);
+
+    const Color color(0x80FFFFFF);
+    const uint32_t ink_pixel = Color::alpha_blending(color, Color::Black()).get_pixel_color();
+    Screen screen;
+    screen.init_headless(32, 16);
+    screen.draw(font, "HHHH\nWW", 1, 1, color);
+    screen.swap_screens();
+    std::set<std::pair<int, int>> ink = text_pixels(*run);
+    for (int y = 0; y < 16; y++) {
+        for (int x = 0; x < 32; x++) {
+            ASSERT_EQ(screen.frame().get_row(y)[x], ink.count({x - 1, y - 1}) ? ink_pixel : Color::BLACK) << x << "," << y;
+        }
+    }
+}
+
+// Test a drawn text writes exactly its ink, clipped, in every render mode
+TEST(BitmapFontTest, DrawMatchesLayout) {
+    BitmapFont font(BitmapFont::Spacing::PROPORTIONAL);
+    std::set<std::pair<int, int>> ink = text_pixels(*font.layout("Score: 0123"));
+
+    std::vector<uint64_t> hashes;
+    for (Screen::RenderMode mode : {Screen::RenderMode::IMMEDIATE, Screen::RenderMode::DEFERRED,
+                                    Screen::RenderMode::TILED}) {
+        Screen screen;
+        screen.init_headless(64, 48);
+        screen.set_raster_threads(2);
+        screen.set_render_mode(mode);
+        screen.draw(font, "Score: 0123", 3, 2, Color::White());
+        screen.draw(font, std::string("Score: 0123"), -10, 44, Color(0x80FF0000));
+        screen.swap_screens();
+
+        const ScreenBuffer& frame = screen.frame();
+        for (int y = 0; y < 10; y++) {
+            for (int x = 0; x < 64; x++) {
+                bool inked = ink.count({x - 3, y - 2}) > 0;
+                ASSERT_EQ(frame.get_row(y)[x], inked ? Color::WHITE : Color::BLACK) << x << "," << y;
+            }
+        }
+        int clipped_ink = 0;  // of the clipped text
+        for (int y = 44; y < 48; y++) {
+            for (int x = 0; x < 64; x++) clipped_ink += frame.get_row(y)[x] != Color::BLACK;
+        }
+        EXPECT_GT(clipped_ink, 0);
+        hashes.push_back(screen.frame_hash());
+    }
+    EXPECT_EQ(hashes[0], hashes[1]);
+    EXPECT_EQ(hashes[0], hashes[2]);
+}
+
+// Blend mode tests ========================================================= //
+
+// Test the span writers of mode M against the scalar equation, on ARGB and
+// indexed rows
+template <BlendMode M>
+static void check_span_writers(std::mt19937& rng) {
+    std::vector<uint32_t> src(67), dst(67), solid(67), pixels(67);
+    for (size_t i = 0; i < dst.size(); i++) {
+        src[i] = rng();
+        dst[i] = rng() | 0xFF000000;
+    }
+    solid = dst;
+    pixels = dst;
+    blend_solid<M>(solid.data(), solid.size(), src[0]);
+    blend_pixels<M>(pixels.data(), src.data(), pixels.size());
+    for (size_t i = 0; i < dst.size(); i++) {
+        ASSERT_EQ(solid[i], blend_argb<M>(src[0], dst[i])) << static_cast<int>(M) << " at " << i;
+        ASSERT_EQ(pixels[i], blend_argb<M>(src[i], dst[i])) << static_cast<int>(M) << " at " << i;
+    }
+
+    std::vector<Color> colors;
+    for (int i = 0; i < 16; i++) colors.push_back(Color(rng() | 0xFF000000));
+    auto palette = std::make_shared<const Palette>(colors);
+    ScreenBuffer span, single;
+    span.init_indexed(67, 1, palette);
+    single.init_indexed(67, 1, palette);
+    span.begin_frame();
+    single.begin_frame();
+    for (int x = 0; x < 67; x++) span.get_index_row(0)[x] = single.get_index_row(0)[x] = rng() % 16;
+    span.write_span<M>(-5, 70, 0, src[0]);
+    for (int x = 0; x < 67; x++) single.write_pixel<M>(src[0], x, 0);
+    for (int x = 0; x < 67; x++) ASSERT_EQ(span.get_index_row(0)[x], single.get_index_row(0)[x]) << x;
+}
+
+// Test the blend equations on known values and every mode of the span writers
+TEST(BlendModeTest, Equations) {
+    const uint32_t src = 0x80FF4020, dst = 0xFF204080;
+    EXPECT_EQ(blend_argb<BlendMode::OPAQUE>(src, dst), 0xFFFF4020u);
+    EXPECT_EQ(blend_argb<BlendMode::SOURCE_OVER>(src, dst),
+              Color::alpha_blending(Color(src), Color(dst)).get_pixel_color());
+    EXPECT_EQ(blend_argb<BlendMode::ADDITIVE>(src, dst), 0xFFA06090u);
+    EXPECT_EQ(blend_argb<BlendMode::ADDITIVE>(0xFFFFFFFF, dst), 0xFFFFFFFFu);
+    EXPECT_EQ(blend_argb<BlendMode::MULTIPLY>(0xFF808080, dst), 0xFF102040u);
+    EXPECT_EQ(blend_argb<BlendMode::MULTIPLY>(0x00000000, dst), dst);
+    EXPECT_EQ(blend_argb<BlendMode::XOR>(src, dst), 0xFFDF00A0u);
+    EXPECT_EQ(blend_argb<BlendMode::XOR>(src, blend_argb<BlendMode::XOR>(src, dst)), dst);
+
+    std::mt19937 rng(24);
+    check_span_writers<BlendMode::OPAQUE>(rng);
+    check_span_writers<BlendMode::SOURCE_OVER>(rng);
+    check_span_writers<BlendMode::ADDITIVE>(rng);
+    check_span_writers<BlendMode::MULTIPLY>(rng);
+    check_span_writers<BlendMode::XOR>(rng);
+}
+
+// Test the Screen applies the blend mode per draw call, in every render mode:
+// the overlapping part of the second rectangle is blended in its mode, the
+// triangle fill too, and OPAQUE draws are never antialiased
+TEST(BlendModeTest, ScreenDrawsInMode) {
+    const Color base(0xFF406080), top(0x80C08040);
+    for (Screen::RenderMode mode : {Screen::RenderMode::IMMEDIATE, Screen::RenderMode::DEFERRED,
+                                    Screen::RenderMode::TILED}) {
+        Screen screen;
+        screen.init_headless(64, 48);
+        screen.set_raster_threads(2);
+        screen.set_render_mode(mode);
+        screen.set_antialiasing(true);
+        screen.draw(Rectangle2D(Vec2D(0, 0), Vec2D(63, 47)), base, true, base);
+        screen.set_blend_mode(BlendMode::ADDITIVE);
+        screen.draw(Rectangle2D(Vec2D(4, 4), Vec2D(20, 20)), top, true, top);
+        screen.set_blend_mode(BlendMode::XOR);
+        screen.draw(Triangle2D(Vec2D(30, 4), Vec2D(60, 4), Vec2D(30, 34)), top, true, top);
+        screen.set_blend_mode(BlendMode::OPAQUE);
+        screen.draw(Line2D(Vec2D(2, 40), Vec2D(50, 44)), top);
+        EXPECT_EQ(screen.blend_mode(), BlendMode::OPAQUE);
+        screen.swap_screens();
+
+        const ScreenBuffer& frame = screen.frame();
+        const uint32_t base_pixel = base.get_pixel_color();
+        EXPECT_EQ(frame.get_row(10)[10], blend_argb<BlendMode::ADDITIVE>(top.get_pixel_color(), base_pixel));
+        EXPECT_EQ(frame.get_row(10)[4], blend_argb<BlendMode::ADDITIVE>(top.get_pixel_color(), base_pixel));
+        EXPECT_EQ(frame.get_row(21)[21], base_pixel);
+        EXPECT_EQ(frame.get_row(10)[36], blend_argb<BlendMode::XOR>(top.get_pixel_color(), base_pixel));
+
+        int line_pixels = 0;
+        for (int y = 38; y < 47; y++) {
+            for (int x = 0; x < 64; x++) {
+                uint32_t pixel = frame.get_row(y)[x];
+                ASSERT_TRUE(pixel == base_pixel or pixel == (top.get_pixel_color() | 0xFF000000)) << x << "," << y;
+                line_pixels += pixel != base_pixel;
+            }
+        }
+        EXPECT_EQ(line_pixels, 49);  // one per column, no soft edge
+    }
+}
+
+// Frame recorder tests ===================================================== //
+
+// A capture path unique to the running test and process, the stream and its
+// index removed when going out of scope (failed assertions included)
+class CaptureFile {
+public:
+    explicit CaptureFile(const std::string& extension)
+        : m_path(::testing::TempDir() + ::testing::UnitTest::GetInstance()->current_test_info()->name() + "_" +
+                 std::to_string(getpid()) + extension) {}
+    ~CaptureFile() {
+        std::remove(m_path.c_str());
+        std::remove((m_path + ".idx").c_str());
+    }
+    inline const std::string& path() const {return m_path;}
+
+private:
+    std::string m_path;
+};
+
+static std::string read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Index lines (sequence, offset), the comment lines skipped
+static std::vector<std::pair<uint64_t, uint64_t>> read_index(const std::string& path) {
+    std::vector<std::pair<uint64_t, uint64_t>> entries;
+    std::ifstream index(path);
+    std::string line;
+    while (std::getline(index, line)) {
+        if (line.empty() or line[0] == '#') continue;
+        std::istringstream fields(line);
+        uint64_t sequence, offset;
+        fields >> sequence >> offset;
+        entries.push_back({sequence, offset});
+    }
+    return entries;
+}
+
+// Test the captured raw stream holds exactly the presented frames, ARGB and
+// indexed, and the Y4M stream their luma
+TEST(FrameRecorderTest, ScreenCapture) {
+    const CaptureFile raw(".raw");
+    const CaptureFile y4m(".y4m");
+    const std::string& raw_path = raw.path();
+    const std::string& y4m_path = y4m.path();
+    const int frames = 6;
+    const size_t frame_bytes = 40 * 30 * sizeof(uint32_t);
+
+    for (bool indexed : {false, true}) {
+        Screen screen;
+        screen.init_headless(40, 30);
+        if (indexed) screen.set_palette(std::make_shared<const Palette>());
+        ASSERT_TRUE(screen.start_capture(raw_path, FrameRecorder::Format::RAW));
+
+        std::string expected;
+        for (int frame = 0; frame < frames; frame++) {
+            screen.draw(Rectangle2D(Vec2D(frame, 2), Vec2D(frame + 10, 20)), Color::White(), true, Color::Red());
+            screen.swap_screens();
+            for (int y = 0; y < 30; y++) {
+                expected.append(reinterpret_cast<const char*>(screen.frame().get_row(y)), 40 * sizeof(uint32_t));
+            }
+        }
+        screen.stop_capture();
+
+        FrameRecorder::Stats stats = screen.capture_stats();
+        EXPECT_EQ(stats.captured + stats.dropped, static_cast<uint64_t>(frames));
+        EXPECT_EQ(stats.written, stats.captured);
+
+        // Dropped frames leave a gap in the sequence, never in the stream
+        std::string stream = read_file(raw_path);
+        auto entries = read_index(raw_path + ".idx");
+        ASSERT_EQ(entries.size(), stats.written);
+        ASSERT_EQ(stream.size(), stats.written * frame_bytes);
+        for (size_t i = 0; i < entries.size(); i++) {
+            EXPECT_EQ(entries[i].second, i * frame_bytes);
+            EXPECT_EQ(stream.compare(entries[i].second, frame_bytes, expected, entries[i].first * frame_bytes,
+                                     frame_bytes), 0) << "frame " << entries[i].first;
+        }
+    }
+
+    Screen screen;
+    screen.init_headless(40, 30);
+    ASSERT_TRUE(screen.start_capture(y4m_path, FrameRecorder::Format::Y4M, 30));
+    screen.draw(Rectangle2D(Vec2D(0, 0), Vec2D(19, 29)), Color::White(), true, Color::White());
+    screen.swap_screens();
+    screen.stop_capture();
+
+    const std::string header = "YUV4MPEG2 W40 H30 F30:1 Ip A1:1 C444\nFRAME\n";
+    std::string stream = read_file(y4m_path);
+    ASSERT_EQ(stream.size(), header.size() + 40 * 30 * 3);
+    EXPECT_EQ(stream.substr(0, header.size()), header);
+    EXPECT_EQ(read_index(y4m_path + ".idx")[0].second, header.size());
+    EXPECT_EQ(static_cast<uint8_t>(stream[header.size()]), 235);      // white
+    EXPECT_EQ(static_cast<uint8_t>(stream[header.size() + 39]), 16);  // black
+    EXPECT_EQ(static_cast<uint8_t>(stream[header.size() + 40 * 30]), 128);  // no chroma
+}
+
+// Test a full ring drops frames instead of blocking, and every frame taken
+// is written in order
+TEST(FrameRecorderTest, DropsWhenBehind) {
+    const CaptureFile capture(".raw");
+    const std::string& path = capture.path();
+    ScreenBuffer frame;
+    frame.init(320, 240);
+
+    FrameRecorder recorder;
+    ASSERT_TRUE(recorder.start(path, 320, 240, FrameRecorder::Format::RAW, 60, 2));
+    EXPECT_THROW(recorder.start(path, 320, 240), std::runtime_error);
+    ScreenBuffer wrong_size;
+    wrong_size.init(32, 24);
+    EXPECT_THROW(recorder.push(wrong_size), std::runtime_error);
+
+    int pushed = 0;
+    for (int i = 0; i < 200; i++) pushed += recorder.push(frame);
+    recorder.stop();
+
+    FrameRecorder::Stats stats = recorder.stats();
+    EXPECT_EQ(stats.captured, static_cast<uint64_t>(pushed));
+    EXPECT_EQ(stats.captured + stats.dropped, 200u);
+    EXPECT_EQ(stats.written, stats.captured);
+
+    auto entries = read_index(path + ".idx");
+    ASSERT_EQ(entries.size(), stats.written);
+    for (size_t i = 1; i < entries.size(); i++) EXPECT_GT(entries[i].first, entries[i - 1].first);
+    EXPECT_EQ(read_file(path).size(), stats.written * 320 * 240 * sizeof(uint32_t));
+}
+
+// Headless screen tests ==================================================== //
+
+// Draw a few frames of moving shapes and return the hash of every presented frame
+static void draw_scene(Screen& screen, int frame) {
+    float offset = frame * 7.5f;
+    screen.draw(Rectangle2D(Vec2D(10 + offset, 10), Vec2D(60 + offset, 40)), Color::Cyan(), true, Color::Orange());
+    screen.draw(Circle2D(Vec2D(80, 60 + offset), 25), Color::White(), true, Color(0x8000FF00));
+    screen.draw(Triangle2D(Vec2D(5, 90), Vec2D(120 - offset, 20), Vec2D(100, 110)), Color(0x80FFFFFF), true, Color(0x400000FF));
+    screen.draw(Line2D(Vec2D(0, offset), Vec2D(127, 95 - offset)), Color::Red());
+}
+
+static std::vector<uint64_t> render_frames(Screen& screen) {
+    std::vector<uint64_t> hashes;
+    for (int frame = 0; frame < 8; frame++) {
+        draw_scene(screen, frame);
+        screen.swap_screens();
+        hashes.push_back(screen.frame_hash());
+    }
+    return hashes;
+}
+
+// Test a headless screen draws without any window and keeps the presented frame
+TEST(ScreenTest, Headless) {
+    Screen screen;
+    EXPECT_THROW(screen.draw(0, 0, Color::White()), std::runtime_error);
+
+    ASSERT_TRUE(screen.init_headless(16, 8));
+    EXPECT_TRUE(screen.is_headless());
+
+    screen.draw(Rectangle2D(Vec2D(2, 2), Vec2D(5, 4)), Color::Red(), true, Color::Green());
+    screen.swap_screens();
+
+    const ScreenBuffer& frame = screen.frame();
+    EXPECT_EQ(frame.get_row(0)[0], Color::BLACK);
+    EXPECT_EQ(frame.get_row(2)[2], Color::RED);
+    EXPECT_EQ(frame.get_row(3)[3], Color::GREEN);
+
+    // The next frame erases it
+    uint64_t drawn = screen.frame_hash();
+    screen.swap_screens();
+    EXPECT_NE(screen.frame_hash(), drawn);
+    EXPECT_EQ(screen.frame().get_row(3)[3], Color::BLACK);
+}
+
+// Test presenting only the damage gives the same frames as full presents
+TEST(ScreenTest, DamagePresentMatchesFull) {
+    Screen full, damage;
+    full.init_headless(128, 128);
+    damage.init_headless(128, 128);
+    full.set_damage_threshold(0.0f);
+    damage.set_damage_threshold(1.0f);
+
+    EXPECT_EQ(render_frames(damage), render_frames(full));
+}
+
+// Test every render mode gives the same frames
+TEST(ScreenTest, RenderModesMatch) {
+    Screen immediate, deferred, tiled;
+    immediate.init_headless(128, 128);
+    deferred.init_headless(128, 128);
+    tiled.init_headless(128, 128);
+    deferred.set_render_mode(Screen::RenderMode::DEFERRED);
+    tiled.set_raster_threads(4);
+    tiled.set_render_mode(Screen::RenderMode::TILED);
+
+    std::vector<uint64_t> expected = render_frames(immediate);
+    EXPECT_EQ(render_frames(deferred), expected);
+    EXPECT_EQ(render_frames(tiled), expected);
+}
+
+// Test the render thread presents the last frame handed over, and accounts for
+// every frame as presented or dropped
+TEST(ScreenTest, RenderThread) {
+    Screen direct, threaded;
+    direct.init_headless(128, 128);
+    threaded.init_headless(128, 128);
+    uint64_t expected = render_frames(direct).back();
+
+    threaded.set_render_thread(true);
+    EXPECT_TRUE(threaded.has_render_thread());
+    for (int frame = 0; frame < 8; frame++) {
+        draw_scene(threaded, frame);
+        threaded.swap_screens();
+    }
+    threaded.set_render_thread(false);
+    EXPECT_EQ(threaded.frame_hash(), expected);
+
+    Screen::HandoffStats stats = threaded.handoff_stats();
+    EXPECT_EQ(stats.presented + stats.dropped, 8u);
+    EXPECT_GE(stats.max_ms, stats.last_ms);
+
+    // Back to presenting in swap_screens()
+    draw_scene(threaded, 7);
+    threaded.swap_screens();
+    EXPECT_EQ(threaded.frame_hash(), expected);
+}
+
+// Test the per-frame counters and the overlay
+TEST(ScreenTest, FrameStats) {
+#ifndef GRAPHICS_ENABLE_STATS
+    GTEST_SKIP() << "built without GRAPHICS_ENABLE_STATS";
+#endif
+    Screen screen;
+    screen.init_headless(128, 128);
+    draw_scene(screen, 0);
+    screen.draw(Rectangle2D(Vec2D(-50, -50), Vec2D(-10, -10)), Color::White());  // clipped: a call, no pixels
+    screen.swap_screens();
+
+    const FrameStats& stats = screen.frame_stats();
+    EXPECT_EQ(stats.draw_calls[DrawCommand::LINE], 1u);
+    EXPECT_EQ(stats.draw_calls[DrawCommand::TRIANGLE], 1u);
+    EXPECT_EQ(stats.draw_calls[DrawCommand::RECTANGLE], 2u);
+    EXPECT_EQ(stats.draw_calls[DrawCommand::CIRCLE], 1u);
+    EXPECT_EQ(stats.total_draw_calls(), 5u);
+    EXPECT_GT(stats.pixels_opaque, 0u);   // the rectangle and the line
+    EXPECT_GT(stats.pixels_blended, 0u);  // the circle and the triangle
+    EXPECT_GE(stats.frame_ms, stats.raster_ms);
+
+    // A new frame starts from zero
+    screen.swap_screens();
+    EXPECT_EQ(screen.frame_stats().total_draw_calls(), 0u);
+
+    // The overlay draws the bars of the last frame
+    uint64_t without_overlay = screen.frame_hash();
+    screen.set_stats_overlay(true);
+    screen.swap_screens();
+    EXPECT_NE(screen.frame_hash(), without_overlay);
+}
+
+// Test an indexed back buffer gives the same frames as ARGB with palette colors
+TEST(ScreenTest, IndexedMatchesArgb) {
+    auto opaque_scene = [](Screen& screen) {
+        std::vector<uint64_t> hashes;
+        for (int frame = 0; frame < 4; frame++) {
+            float offset = frame * 9.0f;
+            screen.draw(Rectangle2D(Vec2D(10 + offset, 10), Vec2D(60 + offset, 40)), Color::Cyan(), true, Color::Orange());
+            screen.draw(Circle2D(Vec2D(80, 60 + offset), 25), Color::White(), true, Color::Purple());
+            screen.draw(Triangle2D(Vec2D(5, 90), Vec2D(120 - offset, 20), Vec2D(100, 110)), Color::Yellow(), true, Color::Blue());
+            screen.draw(Line2D(Vec2D(0, offset), Vec2D(127, 95 - offset)), Color::Red());
+            screen.swap_screens();
+            hashes.push_back(screen.frame_hash());
+        }
+        return hashes;
+    };
+
+    Screen argb, indexed;
+    argb.init_headless(128, 128);
+    indexed.init_headless(128, 128);
+    indexed.set_palette(std::make_shared<Palette>());
+    EXPECT_EQ(opaque_scene(indexed), opaque_scene(argb));
+
+    // Translucent colors go through the blend table: palette colors only
+    indexed.draw(Rectangle2D(Vec2D(0, 0), Vec2D(20, 20)), Color::Red(), true, Color(0x80FFFFFF));
+    indexed.swap_screens();
+    EXPECT_EQ(indexed.frame().get_row(10)[10], Color::GRAY);
+}
+
+// Test the clip rectangle stack limits every draw call, in every render mode
+TEST(ScreenTest, ClipRectStack) {
+    Screen immediate, tiled;
+    immediate.init_headless(64, 64);
+    tiled.init_headless(64, 64);
+    tiled.set_raster_threads(4);
+    tiled.set_render_mode(Screen::RenderMode::TILED);
+
+    for (Screen* screen : {&immediate, &tiled}) {
+        screen->push_clip_rect({10, 10, 30, 30});
+        screen->push_clip_rect({20, 0, 100, 25});  // intersected: (20, 10) - (39, 24)
+        EXPECT_EQ(screen->clip_rect().x, 20);
+        EXPECT_EQ(screen->clip_rect().h, 15);
+
+        screen->draw(Rectangle2D(Vec2D(0, 0), Vec2D(63, 63)), Color::Red(), true, Color::Green());
+        screen->draw(Line2D(Vec2D(0, 0), Vec2D(63, 63)), Color::Blue());
+        screen->pop_clip_rect();
+        screen->draw(Circle2D(Vec2D(30, 40), 10), Color::White(), true, Color(0x80FF00FF));
+        screen->pop_clip_rect();
+        EXPECT_THROW(screen->pop_clip_rect(), std::runtime_error);
+        screen->swap_screens();
+    }
+
+    const ScreenBuffer& frame = immediate.frame();
+    EXPECT_EQ(frame.get_row(15)[19], Color::BLACK);
+    EXPECT_EQ(frame.get_row(15)[20], Color::GREEN);
+    EXPECT_EQ(frame.get_row(24)[39], Color::GREEN);
+    EXPECT_EQ(frame.get_row(25)[39], Color::BLACK);
+    EXPECT_EQ(frame.get_row(20)[20], Color::BLUE);
+    EXPECT_NE(frame.get_row(35)[30], Color::BLACK);
+    EXPECT_EQ(frame.get_row(45)[30], Color::BLACK);  // the circle is clipped too
+    EXPECT_EQ(tiled.frame_hash(), immediate.frame_hash());
+}